@@ -0,0 +1,32 @@
+#version 100
+
+precision mediump float;
+
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+
+// Gray is the atlas column + 1 (0 is air, +128 when highlighted), alpha is the atlas row
+uniform sampler2D texture0;
+uniform sampler2D atlas;
+uniform vec2 atlasSize;
+uniform vec4 tint;
+uniform float flash;
+
+void main() {
+    vec4 cell = texture2D(texture0, fragTexCoord);
+    float x = floor(cell.r * 255. + .5);
+    float y = floor(cell.a * 255. + .5);
+
+    if (x < 1.) discard;
+
+    bool highlighted = x >= 128.;
+    if (highlighted) x -= 128.;
+
+    vec4 color = texture2D(atlas, (vec2(x - 1., y) + .5) / atlasSize);
+
+    if (highlighted) {
+        gl_FragColor = flash > .5 ? vec4(1.) : color;
+    } else {
+        gl_FragColor = vec4(mix(color.rgb, tint.rgb, tint.a), color.a);
+    }
+}
@@ -8,21 +8,15 @@ uniform sampler2D texture0;
 uniform vec2 iResolution = vec2(0., 0.);
 uniform float iTime = 0.;
 
-float rand(vec2 n) {
-    return fract(sin(dot(n, vec2(12.345, 67.89))) * 98765.1234);
-}
-
-float noise(vec2 n) {
-    const vec2 d = vec2(0.0, 1.0);
-    vec2 b = floor(n), f = smoothstep(vec2(0.0), vec2(1.0), fract(n));
-    return mix(mix(rand(b), rand(b + d.yx), f.x), mix(rand(b + d.xy), rand(b + d.yy), f.x), f.y);
-}
+// Tileable value noise baked by Background::Load, noiseScale maps 3 of its cells onto the screen
+uniform sampler2D noise;
+uniform float noiseScale = 0.09375;
 
 void main() {
     vec2 p_d = fragTexCoord;
     p_d.y -= iTime * 0.2;
     
-    vec2 dest_offset = vec2(noise(p_d * vec2(3)));
+    vec2 dest_offset = vec2(texture(noise, p_d * noiseScale).r);
     dest_offset -= vec2(.5, .5);
     dest_offset *= 2. * 0.01 * (1. - fragTexCoord.t);
 
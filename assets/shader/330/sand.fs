@@ -0,0 +1,31 @@
+#version 330
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+out vec4 finalColor;
+
+// Gray is the atlas column + 1 (0 is air, +128 when highlighted), alpha is the atlas row
+uniform sampler2D texture0;
+uniform sampler2D atlas;
+uniform vec2 atlasSize;
+uniform vec4 tint;
+uniform float flash;
+
+void main() {
+    vec4 cell = texture(texture0, fragTexCoord);
+    float x = floor(cell.r * 255. + .5);
+    float y = floor(cell.a * 255. + .5);
+
+    if (x < 1.) discard;
+
+    bool highlighted = x >= 128.;
+    if (highlighted) x -= 128.;
+
+    vec4 color = texture(atlas, (vec2(x - 1., y) + .5) / atlasSize);
+
+    if (highlighted) {
+        finalColor = flash > .5 ? vec4(1.) : color;
+    } else {
+        finalColor = vec4(mix(color.rgb, tint.rgb, tint.a), color.a);
+    }
+}
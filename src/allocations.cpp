@@ -0,0 +1,138 @@
+#include "allocations.h"
+
+#ifdef ENABLE_ALLOCATION_CHECK
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long long> allocationCount = 0;
+static thread_local int pauseDepth = 0;
+
+long long GetAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+AllocationCheckPause::AllocationCheckPause() {
+    pauseDepth++;
+}
+
+AllocationCheckPause::~AllocationCheckPause() {
+    pauseDepth--;
+}
+
+static void* Allocate(std::size_t size, std::size_t alignment) {
+    if (!pauseDepth)
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size = size ? size : 1;
+
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size);
+
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+static void Free(void* pointer, std::size_t alignment) {
+#ifdef _MSC_VER
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(pointer);
+        return;
+    }
+#endif
+
+    std::free(pointer);
+}
+
+void* operator new(std::size_t size) {
+    if (void* pointer = Allocate(size, 0))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* pointer = Allocate(size, (std::size_t) alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, (std::size_t) alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, (std::size_t) alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete[](void* pointer) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    Free(pointer, 0);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    Free(pointer, (std::size_t) alignment);
+}
+
+#endif
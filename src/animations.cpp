@@ -1,6 +1,7 @@
 #include "game.h"
 #include "animations.h"
 #include "debug.h"
+#include "easetables.h"
 
 void ConnectionAnim::update(Game* game) {
     const int waitBeforeFade = 10;
@@ -20,7 +21,7 @@ void ConnectionAnim::update(Game* game) {
             }
         }
 
-        if (isWhite)
+        if (isWhite && drawPixels)
             DrawPixel(pos.x, pos.y, WHITE);
     }
 
@@ -122,7 +123,7 @@ void LevelUpAnimation::update(Game* game) {
     const int maxFallBackDistance = 16;
 
     timer++;
-    tint = Color {0, 0, 0, (unsigned char) EaseCubicInOut(std::min(timer, opacityDuration), opacityDuration, 0, 150)};
+    tint = Color {0, 0, 0, (unsigned char) EaseTicks<EaseCurve::CubicInOut, opacityDuration>(timer, 0, 150)};
     int x = (timer - opacityDuration - fadeDelay) * 2;
 
     bool isWhite = timer % 40 < 20;
@@ -132,7 +133,8 @@ void LevelUpAnimation::update(Game* game) {
         SandParticle* particle = game->simulation.GetAt(pos.x, pos.y);
         if (!particle->occupied) continue;
 
-        DrawPixel(pos.x, pos.y, isWhite ? WHITE : particle->color);
+        if (drawPixels)
+            DrawPixel(pos.x, pos.y, isWhite ? WHITE : game->GetSandColor(*particle));
         
         // Randomly Remove Pixel
         if (pos.x < x) {
@@ -174,7 +176,7 @@ void FadeInCenterText::update() {
     };
 
     // Update the alpha channel of the colors
-    std::vector<Color> alphaColors;
+    alphaColors.clear();
     for (auto& color : colors) {
         alphaColors.push_back(ColorAlpha(color, alpha));
     }
@@ -1,36 +1,37 @@
+#include <cmath>
+#include <fstream>
 #include "app.h"
+#include "allocations.h"
 #include "assets.h"
 #include "debug.h"
 #include "game.h"
 #include "intro.h"
 #include "ending.h"
+#include "spritebatch.h"
 
 // Load the application
 void Application::Load() {
     InitWindow(screenWidth, screenHeight, "Sandy Tetris");
     InitAudioDevice();
     SetConfigFlags(FLAG_MSAA_4X_HINT);
-    SetTargetFPS(60);
 
-    LoadAssets();
-
-    Shader &heatShader = GetShader(Shaders::Heat);
-
-    iResoluationLoc = GetShaderLocation(heatShader, "iResolution");
-    iTimeLoc = GetShaderLocation(heatShader, "iTime");
-    time = 0;
+    input.Load({KEY_A, KEY_D, KEY_S, KEY_W, KEY_LEFT, KEY_RIGHT, KEY_DOWN, KEY_UP, KEY_SPACE});
+    SetTargetFPS(input.PumpsEvents() ? 0 : targetFps);
 
-    float res[2] = {(float) screenWidth, (float) screenHeight};
-
-    SetShaderValue(heatShader, iResoluationLoc, res, SHADER_UNIFORM_VEC2);
-    SetShaderValue(heatShader, iTimeLoc, 0, SHADER_UNIFORM_FLOAT);
+    LoadAssets();
+    background.Load(settings.backgroundScale, settings.backgroundRefresh);
 
     const char fontCharacters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.,;:?!-_~#\"\'&()[]{}^|`/\\@+=%$<>";
 
-    font = PixelFont(GetTexture(Textures::font), fontCharacters, 4, Color {255, 0, 0, 255});
+    font = PixelFont(GetTexture(Textures::font), GetImage(Textures::font), fontCharacters, 4, Color {255, 0, 0, 255});
 
-    game = new Game(this);
-    game->Load();
+    if (settings.boards > 1) {
+        LoadTournament();
+    } else {
+        game = new Game(this);
+        game->Load();
+        boards = {game};
+    }
     intro = new Intro(this);
     intro->Load();
     ending = new Ending(this);
@@ -42,19 +43,45 @@ void Application::Load() {
         SetMusicVolume(music, 0.5f);
     }
 
+    audio.enabled = settings.sfx;
+    audio.Load(settings.soundVoices, settings.music ? &music : nullptr, settings.audioThread);
+
+    hitchDetector.budgetMs = settings.hitchBudgetMs;
+    pacer.enabled = settings.idlePacing;
+    pacer.idleFps = settings.idleFps;
+
     state = Application::States::Intro;
 }
 
 // Run the application
 void Application::Run() {
+#ifdef ENABLE_ALLOCATION_CHECK
+    // Frames in a row with the same state and no transitions, allocations in those are reported
+    const int steadyFrames = 120;
+    int steadyTimer = 0;
+    States lastState = state;
+#endif
+
     while (!WindowShouldClose()) {
-        if (settings.music) {
-            UpdateMusicStream(music);
+        if (pacer.Idle()) {
+            audio.Update();
+
+            if (pacer.WaitForInput(input) || !FrameIsStatic()) {
+                pacer.Wake();
+                hitchDetector.Restart();
+            }
+            continue;
         }
 
-        time += 1;
-        float value[1] = {(float) time / 60};
-        SetShaderValue(GetShader(Shaders::Heat), iTimeLoc, value, SHADER_UNIFORM_FLOAT);
+        double frameStart = InputRecorder::Now();
+        frameArena.Reset();
+        input.SampleFrame();
+
+#ifdef ENABLE_ALLOCATION_CHECK
+        long long allocationsBefore = GetAllocationCount();
+#endif
+
+        audio.Update();
 
         BeginDrawing();
             
@@ -63,28 +90,217 @@ void Application::Run() {
                 intro->Update();
                 break;
             case Application::States::Game:
-                game->Update();
+                if (boards.size() > 1) {
+                    UpdateTournament();
+                } else {
+                    game->Update();
+                }
                 break;
             case Application::States::Ending:
                 ending->Update();
                 break;
         }
         
-        for (auto it = transitions.cbegin(); it != transitions.cend();) {
-            if (it->second->isFinished()) {
-                transitions.erase(it++);
-            } else {
-                it->second->Draw();
-                ++it;
+        {
+            PROFILE_ZONE("Transitions");
+            transitions.Update();
+        }
+
+        {
+            ALLOCATION_CHECK_PAUSE();
+            PROFILE_OVERLAY();
+        }
+
+        {
+            PROFILE_ZONE("EndDrawing");
+            EndDrawing();
+        }
+
+        input.WaitUntil(frameStart + 1.0 / targetFps);
+
+        PROFILE_END_FRAME();
+
+        if (hitchDetector.Update()) {
+            ALLOCATION_CHECK_PAUSE();
+            WriteHitchReport();
+        }
+
+        pacer.FrameDrawn(FrameIsStatic());
+
+#ifdef ENABLE_ALLOCATION_CHECK
+        steadyTimer = (state == lastState && transitions.ActiveCount() == 0) ? steadyTimer + 1 : 0;
+        lastState = state;
+
+        long long allocations = GetAllocationCount() - allocationsBefore;
+        if (allocations && steadyTimer > steadyFrames) {
+            std::cout << "[Error] Frame " << hitchDetector.frameIndex << " made " << allocations << " allocations in a steady state\n";
+            if (frameArena.OverflowCount()) {
+                std::cout << "[Error] " << frameArena.OverflowCount() << " of them didn't fit in the "
+                    << frameArena.Capacity() << " byte frame arena\n";
+            }
+            std::exit(EXIT_FAILURE);
+        }
+#endif
+    }
+}
+
+// Transitions always animate, a minimized window has nothing to show so every screen waits for it
+bool Application::FrameIsStatic() {
+    if (transitions.ActiveCount())
+        return false;
+
+    if (IsWindowMinimized())
+        return true;
+
+    switch (state) {
+        case Application::States::Intro:
+            return intro->IsStatic();
+        case Application::States::Game:
+            for (Game* board : boards) {
+                if (!board->IsStatic())
+                    return false;
             }
+            return true;
+        case Application::States::Ending:
+            return ending->IsStatic();
+    }
+
+    return false;
+}
+
+// Lays the boards out in a grid, each one gets a cell of the screen and a tile of the atlas the same size as its simulation
+void Application::LoadTournament() {
+    int count = settings.boards;
+    int columns = std::ceil(std::sqrt((float) count));
+    int rows = (count + columns - 1) / columns;
+    const float cellPadding = 8;
+
+    float cellWidth = (float) screenWidth / columns;
+    float cellHeight = (float) screenHeight / rows;
+
+    for (int i = 0; i < count; i++) {
+        Game* board = new Game(this);
+        board->boardIndex = i;
+        board->tournament = true;
+        board->viewport = {
+            (i % columns) * cellWidth + cellPadding,
+            (i / columns) * cellHeight + cellPadding,
+            cellWidth - cellPadding * 2,
+            cellHeight - cellPadding * 2
+        };
+
+        // The first two boards are for a local versus game
+        if (settings.autopilot || i > 1) {
+            board->controls = BoardControls::Autopilot;
+        } else {
+            board->controls = i == 0 ? BoardControls::Wasd : BoardControls::Arrows;
+        }
+
+        board->Load();
+        boards.push_back(board);
+    }
+
+    game = boards[0];
+
+    int tileWidth = game->simulation.width;
+    int tileHeight = game->simulation.height;
+    boardAtlas = LoadRenderTexture(tileWidth * columns, tileHeight * rows);
+
+    for (int i = 0; i < count; i++) {
+        atlasTiles.push_back(Rectangle {
+            (float) (i % columns) * tileWidth,
+            (float) (i / columns) * tileHeight,
+            (float) tileWidth,
+            (float) tileHeight
+        });
+    }
+
+    jobs = std::make_unique<JobSystem>(settings.boardThreads);
+}
+
+// Boards only touch their own state while ticking so they step in parallel, everything
+// that talks to raylib stays on this thread
+void Application::UpdateTournament() {
+    for (Game* board : boards) {
+        board->ReadInput();
+    }
+
+    jobs->ParallelFor(boards.size(), [&](int i) {
+        boards[i]->Tick();
+    });
+
+    for (Game* board : boards) {
+        board->ReportInput();
+    }
+
+    BeginTextureMode(boardAtlas);
+        ClearBackground(Colors::dim);
+        for (int i = 0; i < (signed) boards.size(); i++) {
+            boards[i]->DrawTile(atlasTiles[i]);
         }
+    EndTextureMode();
 
-        EndDrawing();
+    BeginSpriteBatch();
+        game->DrawBg();
+        for (int i = 0; i < (signed) boards.size(); i++) {
+            boards[i]->DrawTileOverlay(boardAtlas.texture, atlasTiles[i]);
+        }
+    EndSpriteBatch();
+
+    for (Game* board : boards) {
+        board->UpdateTextParticles();
+        board->PlayQueuedSounds();
+    }
+}
+
+void Application::NewGames() {
+    for (Game* board : boards) {
+        board->NewGame();
+    }
+}
+
+// Append the state of the frame that went over budget to the hitch log
+void Application::WriteHitchReport() {
+    std::ofstream file(settings.hitchLogPath, std::ios::app);
+    if (!file.is_open())
+        return;
+
+    const char* stateNames[] = {"intro", "game", "ending"};
+
+    file << "== Hitch: frame " << hitchDetector.frameIndex << " took " << hitchDetector.lastFrameMs
+        << "ms (budget " << hitchDetector.budgetMs << "ms), state: " << stateNames[(int) state]
+        << ", transitions: " << transitions.ActiveCount() << " ==\n";
+
+#ifdef ENABLE_PROFILER
+    for (auto &zone : Profiler::GetStats()) {
+        file << zone.name << ": " << zone.last << "ms (avg " << zone.avg << "ms, p99 " << zone.p99 << "ms)\n";
+    }
+#endif
+
+    // Any of the tournament boards could have caused it, so all of them are written
+    if (state == Application::States::Game) {
+        for (Game* board : boards) {
+            if (boards.size() > 1)
+                file << "-- board " << board->boardIndex << " --\n";
+            board->WriteSnapshot(file);
+        }
     }
+
+    file << "\n";
 }
 
 // Unload the applicaiton
 void Application::Unload() {
+    hitchDetector.PrintSummary();
+    input.PrintSummary();
+
+    if (pacer.idleTicks) {
+        std::cout << "[Frames] " << pacer.idleTicks << " idle ticks without redrawing\n";
+    }
+
+    input.Unload();
+    audio.Unload();
+    background.Unload();
     UnloadAssets();
     CloseWindow();
 }
@@ -0,0 +1,48 @@
+#include <cstdarg>
+#include <cstdio>
+#include "arena.h"
+
+FrameArena::FrameArena(size_t capacity) : buffer(new char[capacity]), capacity(capacity) {}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    size_t start = (offset + alignment - 1) & ~(alignment - 1);
+
+    if (start + size > capacity) {
+        // Still correct when a frame needs more, but it allocates so make it visible
+        if (overflow.empty())
+            std::cout << "[Error] Frame arena is out of space (" << capacity << " bytes)\n";
+
+        overflow.push_back(std::unique_ptr<char[]>(new char[size + alignment]));
+        size_t address = reinterpret_cast<size_t>(overflow.back().get());
+        return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+    }
+
+    offset = start + size;
+    return buffer.get() + start;
+}
+
+void FrameArena::Reset() {
+    offset = 0;
+    overflow.clear();
+}
+
+std::string_view FrameArena::Format(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+
+    int length = std::vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+
+    if (length < 0) {
+        va_end(argsCopy);
+        return {};
+    }
+
+    char* text = static_cast<char*>(Allocate(length + 1, 1));
+    std::vsnprintf(text, length + 1, format, argsCopy);
+    va_end(argsCopy);
+
+    return {text, (size_t) length};
+}
@@ -1,16 +1,27 @@
+#include <algorithm>
 #include "common.h"
 #include "assets.h"
 #include "debug.h"
+#include "shadercache.h"
 
 std::map<Textures, Texture2D> loadedTextures;
+std::map<Textures, Image> loadedImages;
 std::map<Sounds, Sound> loadedSounds;
 std::map<Shaders, Shader> loadedShaders;
 
 /* ================ Assets ================ */
 
 void LoadAssets() {
+    // Decode once and upload from the decoded image
     for (auto &[name, path] : texturePaths) {
-        loadedTextures[name] = LoadTexture(path);
+        Image image = LoadImage(path);
+        loadedTextures[name] = LoadTextureFromImage(image);
+
+        if (std::find(cpuImages.begin(), cpuImages.end(), name) != cpuImages.end()) {
+            loadedImages[name] = image;
+        } else {
+            UnloadImage(image);
+        }
     }
     
     for (auto &[name, path] : soundPaths) {
@@ -18,7 +29,7 @@ void LoadAssets() {
     }
     
     for (auto &[name, path] : shaderPaths) {
-        loadedShaders[name] = LoadShader(0, path);
+        loadedShaders[name] = LoadShaderCached(path);
     }
 }
 
@@ -26,6 +37,10 @@ void UnloadAssets() {
     for (auto &[name, texture] : loadedTextures) {
         UnloadTexture(texture);
     }
+
+    for (auto &[name, image] : loadedImages) {
+        UnloadImage(image);
+    }
     
     for (auto &[name, sound] : loadedSounds) {
         UnloadSound(sound);
@@ -40,6 +55,10 @@ Texture2D &GetTexture(Textures texture) {
     return loadedTextures.at(texture);
 }
 
+Image &GetImage(Textures texture) {
+    return loadedImages.at(texture);
+}
+
 Sound &GetSound(Sounds sound) {
     return loadedSounds.at(sound);
 }
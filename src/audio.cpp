@@ -0,0 +1,107 @@
+#include <chrono>
+#include "audio.h"
+
+void AudioSystem::Load(int voicesPerSound, Music* music, bool threaded) {
+    this->music = music;
+
+    // The loaded sound is the first voice, the rest share its samples
+    for (auto &[name, path] : soundPaths) {
+        Sound &sound = GetSound(name);
+        std::vector<Voice> &pool = voices[name];
+
+        pool.push_back(Voice {sound, false});
+        for (int i = 1; i < voicesPerSound; i++) {
+            pool.push_back(Voice {LoadSoundAlias(sound), true});
+        }
+    }
+
+    if (threaded) {
+        running = true;
+        thread = std::thread(&AudioSystem::ThreadLoop, this);
+    }
+}
+
+void AudioSystem::Unload() {
+    if (running) {
+        running = false;
+        wake.notify_one();
+        thread.join();
+    }
+
+    for (auto &[name, pool] : voices) {
+        for (Voice &voice : pool) {
+            if (voice.alias)
+                UnloadSoundAlias(voice.sound);
+        }
+    }
+
+    voices.clear();
+
+    if (droppedRequests) {
+        std::cout << "[Error] " << droppedRequests << " sounds were dropped because the audio queue was full\n";
+    }
+}
+
+void AudioSystem::Play(Sounds sound) {
+    if (!enabled)
+        return;
+
+    if (!requests.Push(sound)) {
+        droppedRequests++;
+        return;
+    }
+
+    // Not under the lock, at worst a wake up is missed and the request waits for the next update
+    if (running)
+        wake.notify_one();
+}
+
+void AudioSystem::Update() {
+    if (running)
+        return;
+
+    PlayRequests();
+
+    if (music != nullptr)
+        UpdateMusicStream(*music);
+}
+
+void AudioSystem::ThreadLoop() {
+    while (running) {
+        PlayRequests();
+
+        if (music != nullptr)
+            UpdateMusicStream(*music);
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait_for(lock, std::chrono::milliseconds(updateIntervalMs), [this] {
+            return !running || !requests.Empty();
+        });
+    }
+}
+
+void AudioSystem::PlayRequests() {
+    Sounds sound;
+    while (requests.Pop(sound)) {
+        PlayVoice(sound);
+    }
+}
+
+// Takes a voice that isn't playing, or the one that started first when all of them are
+void AudioSystem::PlayVoice(Sounds sound) {
+    std::vector<Voice> &pool = voices.at(sound);
+    Voice* chosen = &pool[0];
+
+    for (Voice &voice : pool) {
+        if (!IsSoundPlaying(voice.sound)) {
+            chosen = &voice;
+            break;
+        }
+
+        if (voice.startedAt < chosen->startedAt)
+            chosen = &voice;
+    }
+
+    chosen->startedAt = ++playCount;
+    PlaySound(chosen->sound);
+}
@@ -0,0 +1,104 @@
+#include <cmath>
+#include "background.h"
+#include "app.h"
+#include "assets.h"
+#include "spritebatch.h"
+#include "debug.h"
+
+// Lattice cells across the texture, the texture repeats after that. The screen spans
+// screenCells of them and the distortion scrolls up through the rest, so at 32 the same
+// noise only comes back after the scroll has gone through the whole texture
+const int noisePeriod = 32;
+const int noiseSize = noisePeriod * 8;
+const float screenCells = 3;
+const float scrollSpeed = 0.2;  // Screens per second, the same as heat.fs
+
+// Same hash as heat.fs used to evaluate per pixel
+static float NoiseHash(int x, int y) {
+    float value = std::sin((x % noisePeriod) * 12.345f + (y % noisePeriod) * 67.89f) * 98765.1234f;
+    return value - std::floor(value);
+}
+
+static float Smoothstep(float t) {
+    return t * t * (3 - 2 * t);
+}
+
+void Background::Load(float resolutionScale, int _refreshInterval) {
+    refreshInterval = std::max(_refreshInterval, 1);
+
+    int width = std::max((int) (screenWidth * resolutionScale), 1);
+    int height = std::max((int) (screenHeight * resolutionScale), 1);
+    cache = LoadRenderTexture(width, height);
+
+    // Value noise with wrapped lattice coordinates so the texture tiles
+    std::vector<unsigned char> noise(noiseSize * noiseSize);
+    for (int y = 0; y < noiseSize; y++) {
+        for (int x = 0; x < noiseSize; x++) {
+            float nx = (x + 0.5f) * noisePeriod / noiseSize;
+            float ny = (y + 0.5f) * noisePeriod / noiseSize;
+            int bx = nx;
+            int by = ny;
+            float fx = Smoothstep(nx - bx);
+            float fy = Smoothstep(ny - by);
+
+            float top = NoiseHash(bx, by) + (NoiseHash(bx + 1, by) - NoiseHash(bx, by)) * fx;
+            float bottom = NoiseHash(bx, by + 1) + (NoiseHash(bx + 1, by + 1) - NoiseHash(bx, by + 1)) * fx;
+            noise[y * noiseSize + x] = (unsigned char) ((top + (bottom - top) * fy) * 255);
+        }
+    }
+
+    noiseTexture = LoadTextureFromImage(Image {
+        .data = noise.data(),
+        .width = noiseSize,
+        .height = noiseSize,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+    });
+    SetTextureFilter(noiseTexture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(noiseTexture, TEXTURE_WRAP_REPEAT);
+
+    Shader &heatShader = GetShader(Shaders::Heat);
+    timeLoc = GetShaderLocation(heatShader, "iTime");
+    noiseLoc = GetShaderLocation(heatShader, "noise");
+
+    float noiseScale = screenCells / noisePeriod;
+    SetShaderValue(heatShader, GetShaderLocation(heatShader, "noiseScale"), &noiseScale, SHADER_UNIFORM_FLOAT);
+}
+
+void Background::Unload() {
+    UnloadRenderTexture(cache);
+    UnloadTexture(noiseTexture);
+}
+
+void Background::Update(Texture2D source) {
+    frames++;
+
+    if (source.id != lastSource || ++sinceRefresh >= refreshInterval) {
+        Refresh(source);
+        lastSource = source.id;
+        sinceRefresh = 0;
+    }
+}
+
+void Background::Refresh(Texture2D source) {
+    PROFILE_ZONE("Background::Refresh");
+
+    Shader &heatShader = GetShader(Shaders::Heat);
+    // Wrapped once the scroll has gone through the whole texture, where it repeats anyway, so
+    // the shader's coordinates keep their precision however long the game runs
+    float time = std::fmod(frames / 60.0, noisePeriod / screenCells / scrollSpeed);
+    SetShaderValue(heatShader, timeLoc, &time, SHADER_UNIFORM_FLOAT);
+
+    BeginTextureMode(cache);
+        BeginShaderMode(heatShader);
+            SetShaderValueTexture(heatShader, noiseLoc, noiseTexture);
+            DrawTexturePro(source, {0, 0, (float) source.width, (float) source.height},
+                {0, 0, (float) cache.texture.width, (float) cache.texture.height}, {0, 0}, 0, WHITE);
+        EndShaderMode();
+    EndTextureMode();
+}
+
+void Background::Draw() {
+    Rectangle source = {0, 0, (float) cache.texture.width, (float) -cache.texture.height};
+    BatchTexturePro(cache.texture, source, {0, 0, (float) screenWidth, (float) screenHeight}, WHITE, BatchLayer::Background);
+}
@@ -0,0 +1,278 @@
+#include <chrono>
+#include <cmath>
+#include "bot.h"
+#include "debug.h"
+
+Bot::Bot(BotSettings settings) : settings(settings), jobs(settings.threads) {
+    this->settings.levelIndex = std::clamp(settings.levelIndex, 0, maxLevels - 1);
+    level = levels[this->settings.levelIndex];
+}
+
+BotReport Bot::Run() {
+    BotReport report;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int game = 0; game < settings.games; game++) {
+        // Each game gets its own seed so runs are reproducible regardless of thread count
+        std::mt19937 rng(settings.seed + game);
+        PlayGame(rng, report);
+        report.games++;
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void Bot::PrintReport(BotReport report) {
+    double games = std::max(report.games, 1);
+    double seconds = std::max(report.seconds, 0.000001);
+
+    std::cout << "[Bot] Games: " << report.games << ", level: " << settings.levelIndex + 1
+        << ", threads: " << jobs.ThreadCount() << ", settle steps: " << settings.settleSteps
+        << (settings.instantSettle ? " (instant settle after clears)" : "")
+        << (settings.sandFallSpeed > 1 ? ", sand fall speed: " + std::to_string(settings.sandFallSpeed) : "") << "\n";
+    std::cout << "[Bot] Average clears: " << report.clears / games
+        << ", average placements: " << report.placements / games
+        << ", reached required clears (" << level.requiredClears << "): " << report.completedLevels / games * 100 << "%\n";
+    std::cout << "[Bot] " << report.placements << " placements in " << report.seconds << "s ("
+        << report.placements / seconds << " placements/sec, " << report.rollouts / seconds << " rollouts/sec)\n";
+}
+
+void Bot::PlayGame(std::mt19937& rng, BotReport& report) {
+    Simulation board(boardWidth * tileSize, boardHeight * tileSize);
+    board.maxFallSpeed = settings.sandFallSpeed;
+    int clears = 0;
+    int placements = 0;
+
+    while (placements < settings.maxPlacements) {
+        ShapeData shape = GenShape(rng);
+        int best = FindBestPlacement(board, shape);
+        report.rollouts += candidates.size();
+
+        // Every column is full, which is a game over
+        if (best == -1) break;
+
+        board = rollouts[best].board;
+        clears += rollouts[best].clears;
+        placements++;
+    }
+
+    report.placements += placements;
+    report.clears += clears;
+    if (clears >= level.requiredClears)
+        report.completedLevels++;
+}
+
+int Bot::FindBestPlacement(Simulation& board, ShapeData shape) {
+    candidates.clear();
+
+    for (int rotation = 0; rotation < (signed) shapeTypes[shape.type].rotations.size(); rotation++) {
+        shape.rotation = rotation;
+        Rectangle rect = GetShapeRect(shape);
+
+        for (int column = 0; column + rect.width <= board.width / tileSize; column++) {
+            candidates.push_back(Candidate {
+                .rotation = rotation,
+                .x = (int) (column - rect.x) * tileSize
+            });
+        }
+    }
+
+    if (rollouts.size() < candidates.size())
+        rollouts.resize(candidates.size());
+
+    jobs.ParallelFor(candidates.size(), [&](int i) {
+        RunRollout(rollouts[i], board, shape, candidates[i]);
+    });
+
+    int best = -1;
+    for (int i = 0; i < (signed) candidates.size(); i++) {
+        if (rollouts[i].valid && (best == -1 || rollouts[i].score > rollouts[best].score))
+            best = i;
+    }
+
+    return best;
+}
+
+void Bot::RunRollout(Rollout& rollout, Simulation& board, ShapeData shape, Candidate candidate) {
+    shape.rotation = candidate.rotation;
+    rollout.board = board;
+    rollout.clears = 0;
+    rollout.valid = DropShape(rollout.board, shape, candidate.x);
+
+    if (!rollout.valid)
+        return;
+
+    for (int i = 0; i < settings.settleSteps; i++) {
+        rollout.board.Step();
+    }
+
+    rollout.clears = ResolveClears(rollout);
+    rollout.score = ScoreBoard(rollout.board, rollout.clears);
+}
+
+bool Bot::DropShape(Simulation& board, ShapeData shape, int x) {
+    int size = shapeTypes[shape.type].size;
+    const auto &bitmap = shapeTypes[shape.type].rotations[shape.rotation].bitmap;
+    int spawnY = -GetShapeRect(shape).y * tileSize;
+
+    // How far the shape falls before one of its blocks lands on sand or the floor
+    int distance = board.height;
+    for (int i = 0; i < (signed) bitmap.size(); i++) {
+        if (!bitmap[i]) continue;
+
+        Vector2 pos = IndexToPos(i, size);
+        int bottom = spawnY + (pos.y + 1) * tileSize - 1;
+
+        for (int px = 0; px < tileSize; px++) {
+            distance = std::min(distance, board.ColumnTop(x + pos.x * tileSize + px) - 1 - bottom);
+        }
+    }
+
+    if (distance < 0)
+        return false;
+
+    for (int i = 0; i < (signed) bitmap.size(); i++) {
+        if (!bitmap[i]) continue;
+
+        Vector2 pos = IndexToPos(i, size);
+
+        for (int px = 0; px < tileSize; px++) {
+            for (int py = 0; py < tileSize; py++) {
+                board.SetAt(x + pos.x * tileSize + px, spawnY + distance + pos.y * tileSize + py, SandParticle {
+                    .occupied = true,
+                    .type = (unsigned char) shape.color,
+                    .material = shape.material
+                });
+            }
+        }
+    }
+
+    return true;
+}
+
+int Bot::ResolveClears(Rollout& rollout) {
+    const int totalBorderPositions = 4;
+    const Position borderPositions[totalBorderPositions] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    Simulation &board = rollout.board;
+    int clears = 0;
+    bool cleared = true;
+
+    // Same search as Game::FindConnectedSand, but cleared sand is removed right away
+    while (cleared) {
+        cleared = false;
+        board.ResetVisited();
+
+        for (int y = board.height - 1; y > -1 && !cleared; y--) {
+            SandParticle* startingParticle = board.GetAt(0, y);
+            if (!startingParticle->occupied || startingParticle->visited) continue;
+
+            bool connected = false;
+            startingParticle->visited = true;
+
+            rollout.component.clear();
+            rollout.processQueue.clear();
+            rollout.component.push_back({0, y});
+            rollout.processQueue.push_back({0, y});
+
+            while (rollout.processQueue.size()) {
+                Position position = rollout.processQueue.back();
+                rollout.processQueue.pop_back();
+
+                for (int i = 0; i < totalBorderPositions; i++) {
+                    Position newPos = {position.x + borderPositions[i].x, position.y + borderPositions[i].y};
+
+                    SandParticle* particle = board.GetAt(newPos.x, newPos.y);
+                    if (particle == nullptr || !particle->occupied || particle->type != startingParticle->type || particle->visited) continue;
+
+                    if (newPos.x == board.width - 1)
+                        connected = true;
+
+                    particle->visited = true;
+                    rollout.processQueue.push_back(newPos);
+                    rollout.component.push_back(newPos);
+                }
+            }
+
+            if (connected) {
+                for (Position pos : rollout.component) {
+                    board.SetAt(pos.x, pos.y, SandParticle{false});
+                }
+
+                if (settings.instantSettle) {
+                    board.Settle();
+                } else {
+                    for (int i = 0; i < settings.settleSteps; i++) {
+                        board.Step();
+                    }
+                }
+
+                clears++;
+                cleared = true;
+            }
+        }
+    }
+
+    return clears;
+}
+
+float Bot::ScoreBoard(Simulation& board, int clears) {
+    int highest = board.height;
+    int totalHeight = 0;
+    int bumpiness = 0;
+    int matchingNeighbours = 0;
+    int lastTop = -1;
+    int lastType = -1;
+
+    for (int x = 0; x < board.width; x++) {
+        int top = board.ColumnTop(x);
+        int type = top < board.height ? board.GetAt(x, top)->type : -1;
+
+        highest = std::min(highest, top);
+        totalHeight += board.height - top;
+
+        if (lastTop != -1) {
+            bumpiness += std::abs(top - lastTop);
+            if (type != -1 && type == lastType)
+                matchingNeighbours++;
+        }
+
+        lastTop = top;
+        lastType = type;
+    }
+
+    return clears * 1000.0f
+        - (board.height - highest) * 4.0f
+        - (float) totalHeight / board.width
+        - bumpiness * 0.5f
+        + matchingNeighbours * 0.2f;
+}
+
+ShapeData Bot::GenShape(std::mt19937& rng) {
+    ShapeData shape {
+        .type = std::uniform_int_distribution<int>(0, totalShapes - 1)(rng),
+        .color = std::uniform_int_distribution<int>(0, level.maxColors - 1)(rng),
+        .style = std::uniform_int_distribution<int>(0, totalStyles - 1)(rng),
+        .rotation = 0
+    };
+
+    if (level.materials.Mixed()) {
+        shape.material = level.materials.Pick(std::uniform_int_distribution<int>(0, level.materials.Total() - 1)(rng));
+    }
+
+    return shape;
+}
+
+BotSettings LoadBotSettings(Config& config) {
+    BotSettings settings;
+    settings.games = config.GetInt("games", settings.games);
+    settings.levelIndex = config.GetInt("level", settings.levelIndex + 1) - 1;
+    settings.settleSteps = config.GetInt("steps", settings.settleSteps);
+    settings.instantSettle = config.GetBool("instant-settle", settings.instantSettle);
+    settings.sandFallSpeed = std::clamp(config.GetInt("sand-fall-speed", settings.sandFallSpeed), 1, 255);
+    settings.maxPlacements = config.GetInt("placements", settings.maxPlacements);
+    settings.threads = config.GetInt("threads", settings.threads);
+    settings.seed = (unsigned int) config.GetInt("seed", settings.seed);
+    return settings;
+}
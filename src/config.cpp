@@ -0,0 +1,84 @@
+#include <fstream>
+#include "config.h"
+
+static std::string Trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+        return "";
+
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+Config::Config(int argc, char** argv) {
+    std::map<std::string, std::string> arguments;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            std::cout << "[Error] Unexpected argument " << arg << "\n";
+            continue;
+        }
+
+        bool hasValue = i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0;
+        arguments[arg.substr(2)] = hasValue ? argv[++i] : "1";
+    }
+
+    if (arguments.count("config") && !LoadFile(arguments["config"])) {
+        std::cout << "[Error] Could not open config file " << arguments["config"] << "\n";
+    }
+
+    // The command line takes priority over the file
+    for (auto &[key, value] : arguments) {
+        values[key] = value;
+    }
+}
+
+bool Config::LoadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = Trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#' || line[0] == '[')
+            continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            values[line] = "1";
+        } else {
+            values[Trim(line.substr(0, equals))] = Trim(line.substr(equals + 1));
+        }
+    }
+
+    return true;
+}
+
+bool Config::Has(const std::string& key) {
+    return values.count(key);
+}
+
+std::string Config::GetString(const std::string& key, const std::string& fallback) {
+    auto pos = values.find(key);
+    return pos != values.end() ? pos->second : fallback;
+}
+
+int Config::GetInt(const std::string& key, int fallback) {
+    auto pos = values.find(key);
+    return pos != values.end() ? std::atoi(pos->second.c_str()) : fallback;
+}
+
+float Config::GetFloat(const std::string& key, float fallback) {
+    auto pos = values.find(key);
+    return pos != values.end() ? (float) std::atof(pos->second.c_str()) : fallback;
+}
+
+bool Config::GetBool(const std::string& key, bool fallback) {
+    auto pos = values.find(key);
+    if (pos == values.end())
+        return fallback;
+
+    return pos->second != "0" && pos->second != "false" && pos->second != "off";
+}
@@ -0,0 +1,72 @@
+#include "easetables.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define EASE_SSE2
+#endif
+
+struct BakedEase {
+    EaseCurve curve;
+    int duration;
+    const float* table;
+};
+
+// The (curve, duration) pairs the transitions and animations use
+static const BakedEase bakedEases[] = {
+    {EaseCurve::CubicInOut, 40, easeTable<EaseCurve::CubicInOut, 40>.data()},
+    {EaseCurve::CubicInOut, 50, easeTable<EaseCurve::CubicInOut, 50>.data()},
+};
+
+const float* FindEaseTable(EaseCurve curve, int duration) {
+    for (const BakedEase &baked : bakedEases) {
+        if (baked.curve == curve && baked.duration == duration)
+            return baked.table;
+    }
+    return nullptr;
+}
+
+#ifdef EASE_SSE2
+static __m128 EvaluateEase4(EaseCurve curve, __m128 t) {
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 two = _mm_set1_ps(2);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    switch (curve) {
+        case EaseCurve::CubicIn:
+            return _mm_mul_ps(_mm_mul_ps(t, t), t);
+        case EaseCurve::CubicOut: {
+            __m128 u = _mm_sub_ps(t, one);
+            return _mm_add_ps(_mm_mul_ps(_mm_mul_ps(u, u), u), one);
+        }
+        case EaseCurve::CubicInOut: {
+            // Both halves are computed and blended on t < 1
+            __m128 u = _mm_mul_ps(t, two);
+            __m128 in = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(u, u), u), half);
+            __m128 v = _mm_sub_ps(u, two);
+            __m128 out = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(v, v), v), two), half);
+            __m128 mask = _mm_cmplt_ps(u, one);
+            return _mm_or_ps(_mm_and_ps(mask, in), _mm_andnot_ps(mask, out));
+        }
+    }
+    return t;
+}
+#endif
+
+void EaseBatch(EaseCurve curve, const float* currentTime, const float* totalTime,
+    const float* startValue, const float* totalChange, float* out, int count) {
+
+    int i = 0;
+
+#ifdef EASE_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_div_ps(_mm_loadu_ps(currentTime + i), _mm_loadu_ps(totalTime + i));
+        __m128 eased = EvaluateEase4(curve, t);
+        __m128 value = _mm_add_ps(_mm_loadu_ps(startValue + i), _mm_mul_ps(_mm_loadu_ps(totalChange + i), eased));
+        _mm_storeu_ps(out + i, value);
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = startValue[i] + totalChange[i] * EvaluateEase(curve, currentTime[i] / totalTime[i]);
+    }
+}
@@ -125,6 +125,11 @@ void Ending::Load() {
     texts.back().stayTime = -1;
 }
 
+// The last line stays on screen once it has faded in
+bool Ending::IsStatic() {
+    return !inbetweenTimer && texts.size() == 1 && texts.front().holding();
+}
+
 void Ending::Update() {
     ClearBackground({12, 5, 1, 255});
 
@@ -1,16 +1,103 @@
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include "app.h"
 #include "game.h"
 #include "assets.h"
 #include "debug.h"
+#include "spritebatch.h"
+#include "rlgl.h"
+
+void LoadBoardGeometry(Config& config) {
+    // The widest shape is 4 tiles, anything narrower can't be played
+    tileSize = std::max(config.GetInt("tile-size", tileSize), 1);
+    boardWidth = std::max(config.GetInt("board-width", boardWidth), 4);
+    boardHeight = std::max(config.GetInt("board-height", boardHeight), 4);
+    scale = std::max(config.GetFloat("scale", scale), 0.01f);
+}
 
 void Game::Load() {
     simulation = Simulation(boardWidth * tileSize, boardHeight * tileSize);
-    boardTex = LoadRenderTexture(simulation.width, simulation.height);
+    simulation.maxFallSpeed = app->settings.sandFallSpeed;
+
+    // Tournament boards already tick on the application's threads and label on their own
+    if (!tournament)
+        labelJobs = std::make_unique<JobSystem>(app->settings.labelThreads);
+
+    rng.seed(GetRandomValue(0, 1 << 30) + boardIndex);
+    queuedSounds.reserve(16);
+
+    // Tournament boards draw into the application's atlas instead
+    if (!tournament)
+        boardTex = LoadRenderTexture(simulation.width, simulation.height);
+
     bgAnimation = Timer {240};
-    blocksImg = LoadImageFromTexture(GetTexture(Textures::blocks));
+    blocksImg = GetImage(Textures::blocks);
     levelIndex = 0;
+
+    // A flood fill or an animation can cover the whole board, reserved for that so nothing allocates mid game
+    int boardCells = simulation.width * simulation.height;
+    connectVisited.reserve(boardCells);
+    connectQueue.reserve(boardCells);
+    scanVisited.reserve(boardCells);
+    connectionAnim.positions.reserve(boardCells);
+    levelUpAnim.positions.reserve(boardCells);
+    gameOverParticleAnim.particles.reserve(boardCells);
+    textParticles.Load(&app->font);
+
+    // Decode the blocks texture once so coloring sand is a plain array lookup
+    Color* colors = LoadImageColors(blocksImg);
+    blockPixels.assign(colors, colors + blocksImg.width * blocksImg.height);
+    UnloadImageColors(colors);
+
+    // Build the particles of every material, style and color tile up front, new blocks are copied from these a row at a time
+    blockParticles.resize(totalMaterials * totalStyles * totalColors * tileSize * tileSize);
+    for (int material = 0; material < totalMaterials; material++) {
+        for (int style = 0; style < totalStyles; style++) {
+            for (int color = 0; color < totalColors; color++) {
+                SandParticle* tile = &blockParticles[((material * totalColors + color) * totalStyles + style) * tileSize * tileSize];
+
+                for (int y = 0; y < tileSize; y++) {
+                    for (int x = 0; x < tileSize; x++) {
+                        tile[y * tileSize + x] = SandParticle {
+                            .occupied = true,
+                            .type = (unsigned char) color,
+                            .atlasX = (unsigned char) (style * blockTextureSize + x * blockTextureSize / tileSize),
+                            .atlasY = (unsigned char) (color * blockTextureSize + y * blockTextureSize / tileSize),
+                            .material = (Material) material
+                        };
+                    }
+                }
+            }
+        }
+    }
+
+    // A shader that failed to compile comes back as the default one, keep drawing on the CPU then
+    Shader &sandShader = GetShader(Shaders::Sand);
+    gpuSand = app->settings.gpuSand && sandShader.id != rlGetShaderIdDefault();
+
+    if (gpuSand) {
+        sandPlanes.assign(simulation.width * simulation.height * 2, 0);
+        sandPlaneTex = LoadTextureFromImage(Image {
+            .data = sandPlanes.data(),
+            .width = simulation.width,
+            .height = simulation.height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA
+        });
+
+        sandAtlasLoc = GetShaderLocation(sandShader, "atlas");
+        sandAtlasSizeLoc = GetShaderLocation(sandShader, "atlasSize");
+        sandTintLoc = GetShaderLocation(sandShader, "tint");
+        sandFlashLoc = GetShaderLocation(sandShader, "flash");
+
+        Texture2D &blocks = GetTexture(Textures::blocks);
+        float atlasSize[2] = {(float) blocks.width, (float) blocks.height};
+        SetShaderValue(sandShader, sandAtlasSizeLoc, atlasSize, SHADER_UNIFORM_VEC2);
+    }
+
+    connectionAnim.drawPixels = !gpuSand;
+    levelUpAnim.drawPixels = !gpuSand;
 }
 
 void Game::NewGame() {
@@ -20,7 +107,7 @@ void Game::NewGame() {
     connectionAnim.reset();
     gameOverAnim.reset();
     gameOverParticleAnim.reset();
-    textParticles.clear();
+    textParticles.Clear();
     sinceSandUpdate = 0;
     startDelay = 90;
     comboTimer = 0;
@@ -31,19 +118,29 @@ void Game::NewGame() {
     // Game Over
     gameOverTimer = 0;
     gameOver = false;
+    autopilotX = -1;
+    labelNextScan = true;
+    ResetInput();
 
     // Panel Positions
-    boardRect = {
-        0, 0, 
-        boardWidth * tileSize * scale, 
-        boardHeight * tileSize * scale
-    };
-
     nextShapeRect = {
         0, 
         0,
-        tileSize * scale * 5 + panelMarginSide * 2,
-        tileSize * scale * 3 + panelMarginTop * 3,
+        panelTileSize * 5 + panelMarginSide * 2,
+        panelTileSize * 3 + panelMarginTop * 3,
+    };
+
+    // Shrink the board when the configured geometry doesn't fit on the screen
+    boardScale = std::min({
+        scale,
+        (screenWidth - nextShapeRect.width - panelPadding * 3) / simulation.width,
+        (float) (screenHeight - panelPadding * 2) / simulation.height
+    });
+
+    boardRect = {
+        0, 0, 
+        simulation.width * boardScale, 
+        simulation.height * boardScale
     };
 
     infoPanelRect = {
@@ -59,6 +156,15 @@ void Game::NewGame() {
     infoPanelRect.x = nextShapeRect.x;
     infoPanelRect.y = nextShapeRect.y + nextShapeRect.height + panelPadding;
 
+    // Tournament boards fill their cell of the grid and have no panels
+    if (tournament) {
+        boardScale = std::min({scale, viewport.width / simulation.width, viewport.height / simulation.height});
+        boardRect.width = simulation.width * boardScale;
+        boardRect.height = simulation.height * boardScale;
+        boardRect.x = viewport.x + (viewport.width - boardRect.width) / 2;
+        boardRect.y = viewport.y + (viewport.height - boardRect.height) / 2;
+    }
+
     // Stats
     level = levels[levelIndex];
     stats = Statistics {
@@ -75,35 +181,134 @@ void Game::NewGame() {
 }
 
 void Game::Update() {
-    bool paused = false;
-    Vector2 screenShake = {0, 0};
+    ReadInput();
+    Tick();
+    ReportInput();
+    Draw();
+    PlayQueuedSounds();
+}
 
-    if (gameOver)
-        paused = true;
+void Game::ReadInput() {
+    focusPaused = app->settings.pauseUnfocused && controls != BoardControls::Autopilot && !IsWindowFocused();
+
+    if (controls == BoardControls::Autopilot) {
+        UpdateAutopilot();
+        return;
+    }
+
+    input = inputReader.Read(app->input, InputRecorder::Now());
+}
+
+// Starts reading the recorder from now on, with every key up
+void Game::ResetInput() {
+    bool wasd = controls != BoardControls::Arrows;
+    bool arrows = controls != BoardControls::Wasd;
+
+    const KeyBinding wasdBindings[] = {
+        {KEY_A, InputAction::Left}, {KEY_D, InputAction::Right},
+        {KEY_S, InputAction::Down}, {KEY_W, InputAction::Rotate}
+    };
+    const KeyBinding arrowBindings[] = {
+        {KEY_LEFT, InputAction::Left}, {KEY_RIGHT, InputAction::Right},
+        {KEY_DOWN, InputAction::Down}, {KEY_UP, InputAction::Rotate}
+    };
+
+    // Kept on the stack, boards on autopilot restart in the middle of a steady state
+    KeyBinding bindings[9] = {{KEY_SPACE, InputAction::HoldRotation}};
+    int count = 1;
+    if (wasd) {
+        std::copy(std::begin(wasdBindings), std::end(wasdBindings), bindings + count);
+        count += 4;
+    }
+    if (arrows) {
+        std::copy(std::begin(arrowBindings), std::end(arrowBindings), bindings + count);
+        count += 4;
+    }
+
+    inputReader.dasMs = app->settings.dasMs;
+    inputReader.arrMs = app->settings.arrMs;
+    inputReader.tickMs = 1000.0f / targetFps;
+    inputReader.Reset(app->input, std::span(bindings, count), InputRecorder::Now());
+
+    consumedMovePress = 0;
+    consumedRotatePress = 0;
+}
+
+void Game::ReportInput() {
+    double now = InputRecorder::Now();
+
+    if (consumedMovePress)
+        app->input.RecordLatency(now - consumedMovePress);
+    if (consumedRotatePress)
+        app->input.RecordLatency(now - consumedRotatePress);
+
+    consumedMovePress = 0;
+    consumedRotatePress = 0;
+}
+
+// Turns the shape towards a random rotation and moves it over a random column, then drops it
+void Game::UpdateAutopilot() {
+    input = GameInput {};
+
+    if (currentShape.type == -1 || startDelay || gameOver) {
+        autopilotX = -1;
+        return;
+    }
+
+    if (autopilotX == -1) {
+        autopilotRotation = Random(0, shapeTypes[currentShape.type].rotations.size() - 1);
+        autopilotX = Random(0, simulation.width - tileSize);
+    }
+
+    if (currentShape.rotation != autopilotRotation) {
+        input.rotate = true;
+        return;
+    }
+
+    Rectangle shapeRect = GetShapeRect(currentShape);
+    float left = cShapePos.x + shapeRect.x * tileSize;
+    float target = std::min((float) autopilotX, simulation.width - shapeRect.width * tileSize);
+
+    input.left = left > target + level.horizontalSpeed;
+    input.right = left < target - level.horizontalSpeed;
+    input.down = !input.left && !input.right;
+}
+
+// Checks the window itself so the pacer wakes up as soon as focus comes back
+bool Game::IsStatic() {
+    return focusPaused && !IsWindowFocused() && !gameOver && !connectionAnim.active && !levelUpAnim.active
+        && !textParticles.Count() && !verticalShakeTimer && !horizontalShakeTimer;
+}
+
+void Game::Tick() {
+    PROFILE_ZONE("Game::Tick");
+
+    paused = gameOver || focusPaused;
+    screenShake = {0, 0};
 
     if (verticalShakeTimer > 0) {
         verticalShakeTimer--;
-        screenShake.y = GetRandomValue(-scale, scale);
-        boardRect.y -= screenShake.y;
-        nextShapeRect.y -= screenShake.y;
-        infoPanelRect.y -= screenShake.y;
+        screenShake.y = Random(-scale, scale);
     }
 
     if (horizontalShakeTimer > 0) {
         horizontalShakeTimer--;
-        screenShake.x = GetRandomValue(-scale, scale);
-        boardRect.x -= screenShake.x;
-        nextShapeRect.x -= screenShake.x;
-        infoPanelRect.x -= screenShake.x;
+        screenShake.x = Random(-scale, scale);
     }
+
+    // Taken back off once the board is drawn
+    OffsetLayout({-screenShake.x, -screenShake.y});
     
-    if (startDelay) {
+    if (startDelay && !focusPaused) {
         startDelay--;
         paused = true;
 
         if (startDelay == 50) {
-            textParticles.push_back(TextParticle {
-                .text = "Level " + std::to_string(levelIndex + 1),
+            // Boards tick in parallel so this can't use the application's frame arena
+            char levelText[32];
+            int length = std::snprintf(levelText, sizeof(levelText), "Level %d", levelIndex + 1);
+
+            textParticles.Spawn(std::string_view(levelText, length), TextParticle {
                 .startPos = {boardRect.x + boardRect.width / 2, boardRect.y + boardRect.height / 2 - 15},
                 .size = 3,
                 .color = Colors::orange2,
@@ -119,7 +324,6 @@ void Game::Update() {
             nextShape = GenShape();
     }
 
-
     if (!connectionAnim.active && !levelUpAnim.active && !paused) {
         if (++sinceSandUpdate > 1) {
             simulation.Step();
@@ -142,62 +346,130 @@ void Game::Update() {
             comboCount = 0;
         }
     }
+}
 
-    DrawBg();
-    DrawNextShape();
-    DrawInfoPanel();
+void Game::Draw() {
+    // The background, panels and their contents go out in a handful of draw calls
+    BeginSpriteBatch();
+        DrawBg();
+        DrawNextShape();
+        DrawInfoPanel();
+    EndSpriteBatch();
 
     BeginTextureMode(boardTex);
         ClearBackground(Colors::dim);
+        DrawBoardContents();
+    EndTextureMode();
 
+    Rectangle boardTexSource = {0, 0, (float) boardTex.texture.width, (float) -boardTex.texture.height};
+    DrawTexturePro(boardTex.texture, boardTexSource, boardRect, {0, 0}, 0, WHITE);
+
+    if (focusPaused)
+        app->font.RenderCenteredRec(boardRect, "Paused", 3, Colors::orange2);
+
+    UpdateTextParticles();
+    OffsetLayout(screenShake);
+}
+
+void Game::OffsetLayout(Vector2 offset) {
+    boardRect.x += offset.x;
+    boardRect.y += offset.y;
+    nextShapeRect.x += offset.x;
+    nextShapeRect.y += offset.y;
+    infoPanelRect.x += offset.x;
+    infoPanelRect.y += offset.y;
+}
+
+// Sand, the falling shape and the board animations in board coordinates
+void Game::DrawBoardContents() {
+    if (gpuSand) {
+        DrawSandWithShader();
+    } else {
         DrawSandToTex();
+    }
 
-        if (currentShape.type != -1 && !levelUpAnim.active && !paused)
-            DrawShape(currentShape, {std::floor(cShapePos.x), std::floor(cShapePos.y)}, 1);
-        
-        if (connectionAnim.active) {
-            UpdateConnectAnim();
-        }
+    if (currentShape.type != -1 && !levelUpAnim.active && !paused)
+        DrawShape(currentShape, {std::floor(cShapePos.x), std::floor(cShapePos.y)}, tileSize);
+    
+    if (connectionAnim.active) {
+        UpdateConnectAnim();
+    }
 
-        if (gameOver) {
-            UpdateGameOverAnim();
-        }
+    if (gameOver) {
+        UpdateGameOverAnim();
+    }
 
-        if (levelUpAnim.active) {
-            UpdateLevelUpAnim();
-        }
+    if (levelUpAnim.active) {
+        UpdateLevelUpAnim();
+    }
+}
 
-    EndTextureMode();
+// Called with the tournament atlas as the render target, the atlas is cleared before the boards draw
+void Game::DrawTile(Rectangle tile) {
+    BeginScissorMode(tile.x, tile.y, tile.width, tile.height);
+    rlPushMatrix();
+    rlTranslatef(tile.x, tile.y, 0);
 
-    Rectangle boardTexSource = {0, 0, (float) boardTex.texture.width, (float) -boardTex.texture.height};
-    DrawTexturePro(boardTex.texture, boardTexSource, boardRect, {0, 0}, 0, WHITE);
+    DrawBoardContents();
 
-    UpdateTextParticles();
-    
-    // Add back the shake offset
-    boardRect.x += screenShake.x;
-    boardRect.y += screenShake.y;
-    nextShapeRect.x += screenShake.x;
-    nextShapeRect.y += screenShake.y;
-    infoPanelRect.x += screenShake.x;
-    infoPanelRect.y += screenShake.y;
+    rlPopMatrix();
+    EndScissorMode();
+}
+
+// Called inside the sprite batch that draws every tile, which is one draw call for the atlas
+void Game::DrawTileOverlay(Texture2D atlas, Rectangle tile) {
+    Rectangle source = {tile.x, atlas.height - tile.y - tile.height, tile.width, -tile.height};
+    BatchTexturePro(atlas, source, boardRect, WHITE, BatchLayer::Board);
+    DrawBorder(boardRect, 2, Colors::orange0);
+
+    std::string_view scoreText = app->frameArena.Format("%d  %d/%d", stats.score, stats.clears, level.requiredClears);
+    app->font.Render(scoreText, {boardRect.x + 4, boardRect.y + 4}, 1, Colors::orange2);
+
+    if (focusPaused)
+        app->font.RenderCenteredRec(boardRect, "Paused", 2, Colors::orange2);
+
+    OffsetLayout(screenShake);
+}
+
+void Game::QueueSound(Sounds sound) {
+    queuedSounds.push_back(sound);
+}
+
+// Only boards someone is playing make sounds
+void Game::PlayQueuedSounds() {
+    if (controls != BoardControls::Autopilot) {
+        for (Sounds sound : queuedSounds) {
+            app->audio.Play(sound);
+        }
+    }
+
+    queuedSounds.clear();
+}
+
+int Game::Random(int min, int max) {
+    return std::uniform_int_distribution<int>(min, max)(rng);
 }
 
 void Game::DrawBg() {
+    PROFILE_ZONE("Game::DrawBg");
+
     // Draw Background
-    BeginShaderMode(GetShader(Shaders::Heat));
+    // The background holds still with the rest of the board while it's paused for focus
+    if (!focusPaused) {
         Texture2D &texture = (bgAnimation.timer < bgAnimation.total / 2) ? GetTexture(Textures::desertBg2) : GetTexture(Textures::desertBg1);
-        DrawTexturePro(texture, {0, 0, (float) texture.width, (float) texture.height}, {0, 0, (float) screenWidth, (float) screenHeight}, {0, 0}, 0, WHITE);
-    EndShaderMode();
+        app->background.Update(texture);
+        bgAnimation.update();
+    }
 
-    bgAnimation.update();
+    app->background.Draw();
 
-    // Draw Board Border
-    DrawBorder(boardRect, panelBorderThickness, Colors::orange0);
+    // Draw Board Border, tournament boards draw their own in DrawTileOverlay
+    if (!tournament)
+        DrawBorder(boardRect, panelBorderThickness, Colors::orange0);
 }
 
 void Game::DrawNextShape() {
-    DrawRectangleRec(nextShapeRect, Colors::dim);
+    BatchRectangle(nextShapeRect, Colors::dim);
     DrawBorder(nextShapeRect, panelBorderThickness, Colors::orange0);
     
     float y = nextShapeRect.y + panelMarginTop;
@@ -220,15 +492,15 @@ void Game::DrawNextShape() {
         y + (nextShapeRect.height - (y - nextShapeRect.y)) / 2
     };
     Vector2 shapePos = {
-        center.x - (shapeRect.x + shapeRect.width / 2) * shapeScale * tileSize,
-        center.y - (shapeRect.y + shapeRect.height / 2) * shapeScale * tileSize,
+        center.x - (shapeRect.x + shapeRect.width / 2) * shapeScale * blockTextureSize,
+        center.y - (shapeRect.y + shapeRect.height / 2) * shapeScale * blockTextureSize,
     };
 
-    DrawShape(nextShape, shapePos, shapeScale);
+    DrawShape(nextShape, shapePos, shapeScale * blockTextureSize);
 }
 
 void Game::DrawInfoPanel() {
-    DrawRectangleRec(infoPanelRect, Colors::dim);
+    BatchRectangle(infoPanelRect, Colors::dim);
     DrawBorder(infoPanelRect, panelBorderThickness, Colors::orange0);
     
     float y = infoPanelRect.y + panelMarginTop;
@@ -238,7 +510,7 @@ void Game::DrawInfoPanel() {
     app->font.Render("Score: ", {infoPanelRect.x + panelMarginSide, y}, textSize, Colors::orange1);
     
     // Score Value
-    std::string scoreStr = std::to_string(localScore);
+    std::string_view scoreStr = app->frameArena.Format("%d", localScore);
     Vector2 scoreTextPos = {
         infoPanelRect.x + infoPanelRect.width - panelMarginSide - app->font.Measure(scoreStr) * textSize, 
         y
@@ -260,7 +532,7 @@ void Game::DrawInfoPanel() {
     app->font.Render("Lines: ", {infoPanelRect.x + panelMarginSide, y}, textSize, Colors::orange1);
         
     // Lines Value
-    std::string linesStr = std::to_string(stats.clears) + "/" + std::to_string(level.requiredClears);
+    std::string_view linesStr = app->frameArena.Format("%d/%d", stats.clears, level.requiredClears);
     Vector2 linesTextPos = {
         infoPanelRect.x + infoPanelRect.width - panelMarginSide - app->font.Measure(linesStr) * textSize, 
         y
@@ -272,7 +544,7 @@ void Game::DrawInfoPanel() {
     app->font.Render("Level: ", {infoPanelRect.x + panelMarginSide, y}, textSize, Colors::orange1);
     
     // Level Value
-    std::string levelStr = std::to_string(levelIndex + 1);
+    std::string_view levelStr = app->frameArena.Format("%d", levelIndex + 1);
     Vector2 levelTextPos = {
         infoPanelRect.x + infoPanelRect.width - panelMarginSide - app->font.Measure(levelStr) * textSize, 
         y
@@ -281,60 +553,99 @@ void Game::DrawInfoPanel() {
 }
 
 void Game::DrawSandToTex() {
-    for (int y = 0; y < simulation.height; y++) {
-        for (int x = 0; x < simulation.width; x++) {
-            SandParticle* particle = simulation.GetAt(x, y);
-            if (!particle->occupied) continue;
+    PROFILE_ZONE("Game::DrawSandToTex");
 
-            if (levelUpAnim.active) {
-                DrawPixel(x, y, ColorAlphaBlend(particle->color, levelUpAnim.tint, WHITE));
-            } else {
-                DrawPixel(x, y, particle->color);
-            }
+    simulation.ForEachParticle([&](int x, int y, SandParticle& particle) {
+        if (levelUpAnim.active) {
+            DrawPixel(x, y, ColorAlphaBlend(GetSandColor(particle), levelUpAnim.tint, WHITE));
+        } else {
+            DrawPixel(x, y, GetSandColor(particle));
         }
-    }
+    });
 }
 
-void Game::MoveShape() {
-    Vector2 movement = {0, 0};
+// Uploads the board as two 8 bit planes (blocks texture column and row of every particle)
+// and lets the sand shader look up the colors, tint and highlight in a single pass
+void Game::DrawSandWithShader() {
+    PROFILE_ZONE("Game::DrawSandWithShader");
 
-    bool down = IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN);
+    const unsigned char highlightBit = 128;
 
-    movement.y += down ? level.fallSpeed * 2 : level.fallSpeed;
+    std::fill(sandPlanes.begin(), sandPlanes.end(), 0);
+    simulation.ForEachParticle([&](int x, int y, SandParticle& particle) {
+        int index = (y * simulation.width + x) * 2;
+        sandPlanes[index] = particle.atlasX + 1;
+        sandPlanes[index + 1] = particle.atlasY;
+    });
 
-    bool right = IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT);
-    bool left = IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT);
+    bool flash = false;
+    std::vector<Position>* highlighted = nullptr;
 
-    if (right && !left) {
-        movement.x += level.horizontalSpeed;
-    } else if (left && !right) {
-        movement.x -= level.horizontalSpeed;
+    if (connectionAnim.active) {
+        highlighted = &connectionAnim.positions;
+        flash = connectionAnim.timer % 40 < 20;
+    } else if (levelUpAnim.active) {
+        highlighted = &levelUpAnim.positions;
+        flash = levelUpAnim.timer % 40 < 20;
     }
 
+    if (highlighted != nullptr) {
+        for (Position pos : *highlighted) {
+            int index = (pos.y * simulation.width + pos.x) * 2;
+            if (sandPlanes[index])
+                sandPlanes[index] |= highlightBit;
+        }
+    }
+
+    UpdateTexture(sandPlaneTex, sandPlanes.data());
+
+    Shader &sandShader = GetShader(Shaders::Sand);
+    Color tint = levelUpAnim.active ? levelUpAnim.tint : BLANK;
+    float tintValue[4] = {tint.r / 255.0f, tint.g / 255.0f, tint.b / 255.0f, tint.a / 255.0f};
+    float flashValue = flash ? 1 : 0;
+
+    SetShaderValue(sandShader, sandTintLoc, tintValue, SHADER_UNIFORM_VEC4);
+    SetShaderValue(sandShader, sandFlashLoc, &flashValue, SHADER_UNIFORM_FLOAT);
+
+    BeginShaderMode(sandShader);
+        SetShaderValueTexture(sandShader, sandAtlasLoc, GetTexture(Textures::blocks));
+        DrawTexture(sandPlaneTex, 0, 0, WHITE);
+    EndShaderMode();
+}
+
+Color Game::GetSandColor(SandParticle& particle) {
+    return blockPixels[particle.atlasY * blocksImg.width + particle.atlasX];
+}
+
+void Game::MoveShape() {
+    Vector2 movement = {0, 0};
+
+    movement.y += level.fallSpeed * (1 + input.down);
+    movement.x += level.horizontalSpeed * (input.right - input.left);
+
+    float oldX = cShapePos.x;
     CheckShapeCollision(movement);
+
+    if (input.movePressTime && cShapePos.x != oldX)
+        consumedMovePress = input.movePressTime;
 }
 
 void Game::RotateShape() {
-    bool up = IsKeyPressed(KEY_W) || IsKeyPressed(KEY_UP);
-    bool down = IsKeyPressed(KEY_S) || IsKeyPressed(KEY_DOWN);
+    if (!input.rotate)
+        return;
+
+    // Every queued press gets its own tick, whatever else was pressed in the same frame
+    inputReader.ConsumeRotation();
 
     int totalRotations = (signed) shapeTypes[currentShape.type].rotations.size();
     int oldRotation = currentShape.rotation;
 
     bool rotated = true;
 
-    if (up && !down) {
-        if (++currentShape.rotation >= totalRotations)
-            currentShape.rotation = 0;
-        
-    } else if (up && !down) {
-        if (--currentShape.rotation < 0)
-            currentShape.rotation = totalRotations - 1;
-    } else {
-        rotated = false;
-    }
+    if (++currentShape.rotation >= totalRotations)
+        currentShape.rotation = 0;
 
-    if (currentShape.rotation != oldRotation && !IsKeyDown(KEY_SPACE)) {
+    if (currentShape.rotation != oldRotation && !input.holdRotation) {
         if (IsShapeColliding()) {
             currentShape.rotation = oldRotation;
             rotated = false;
@@ -344,14 +655,17 @@ void Game::RotateShape() {
     }
 
     if (rotated) {
-        PlaySound(GetSound(Sounds::block_rotate));
+        QueueSound(Sounds::block_rotate);
+
+        if (input.rotatePressTime)
+            consumedRotatePress = input.rotatePressTime;
     }
 }
 
 void Game::TryToCorrectShape() {
     Vector2 oldPos = cShapePos;
     int size = shapeTypes[currentShape.type].size;
-    const auto bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
 
     for (int i = 0; i < (signed) bitmap.size(); i++) {
         if (!bitmap[i]) continue;
@@ -389,7 +703,7 @@ void Game::SpawnShape() {
 
 void Game::CheckShapeCollision(Vector2 mouvement) {
     int size = shapeTypes[currentShape.type].size;
-    const auto bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
 
     bool hitBottom = false;
 
@@ -461,21 +775,19 @@ void Game::CheckShapeCollision(Vector2 mouvement) {
 
     if (hitBottom) {
         TurnShapeToSand();
-        PlaySound(GetSound(Sounds::block_fall));
+        QueueSound(Sounds::block_fall);
         currentShape.type = -1;
     }
 }
 
 void Game::TurnShapeToSand() {
     int size = shapeTypes[currentShape.type].size;
-    const auto bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
 
-    Rectangle src = {
-        (float) currentShape.style * tileSize,
-        (float) currentShape.color * tileSize,
-        tileSize,
-        tileSize
-    };
+    int tileIndex = ((int) currentShape.material * totalColors + currentShape.color) * totalStyles + currentShape.style;
+    const SandParticle* tile = &blockParticles[tileIndex * tileSize * tileSize];
+    int shapeX = std::floor(cShapePos.x);
+    int shapeY = std::floor(cShapePos.y);
 
     for (int i = 0; i < (signed) bitmap.size(); i++) {
         if (!bitmap[i]) continue;
@@ -484,110 +796,136 @@ void Game::TurnShapeToSand() {
         pos.x *= tileSize;
         pos.y *= tileSize;
 
-        for (int x = 0; x < tileSize; x++) {
-            for (int y = 0; y < tileSize; y++) {
-                Position particlePos = {(int) std::floor(cShapePos.x + pos.x + x), (int) std::floor(cShapePos.y + pos.y + y)};
-
-                if (!simulation.ValidPosition(particlePos.x, particlePos.y)) continue;
-
-                simulation.SetAt(particlePos.x, particlePos.y, SandParticle {
-                    .occupied = true,
-                    .color = GetImageColor(blocksImg, src.x + x, src.y + y),
-                    .type = currentShape.color
-                });
-            }
+        for (int y = 0; y < tileSize; y++) {
+            simulation.SetRow(shapeX + pos.x, shapeY + pos.y + y, tile + y * tileSize, tileSize);
         }
     }
 }
 
 void Game::FindConnectedSand() {
+    PROFILE_ZONE("Game::FindConnectedSand");
+
     const int totalBorderPositions = 4;
     const Position borderPositions[totalBorderPositions] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
 
-    // Change all of the particle visited fields to false
-    simulation.ResetVisited();
+    // Nothing was placed, removed or moved since the last scan
+    if (simulation.Generation() == scannedGeneration)
+        return;
 
-    std::string output;
+    scannedGeneration = simulation.Generation();
+    DirtyBox dirty = simulation.TakeDirtyBox();
 
-    for (int y = simulation.height - 1; y > -1; y--) {
-        SandParticle* startingParticle = simulation.GetAt(0, y);
+    // The first scan after a bulk edit and boards too big for the flood fill go through the labeler
+    if (labelNextScan || simulation.width * simulation.height >= app->settings.labelerCells) {
+        labelNextScan = false;
+        labeler.Label(simulation, labelJobs.get());
 
-        // Only process particles that are occupied
-        if (!startingParticle->occupied) continue;
-     
-        bool connected = false;
-        startingParticle->visited = true;
+        for (int label : labeler.SpanningLabels()) {
+            labeler.CollectPositions(label, connectVisited);
+            OnSandConnected(connectVisited);
+        }
+        return;
+    }
 
-        // Vector of all visited positions
-        std::vector<Position> visited;
-        visited.reserve(tileSize * tileSize * 4);
+    // Sand can only have started reaching from wall to wall where it changed, so the flood
+    // fill starts from the sand inside the dirty box instead of everything on the left wall
+    scanVisited.clear();
 
-        // Vector of positions that have yet to be processed
-        std::vector<Position> processQueue;
-        processQueue.push_back({0, y});
-        visited.push_back({0, y});
+    for (int y = dirty.maxY; y >= dirty.minY; y--) {
+        for (int x = dirty.minX; x <= dirty.maxX; x++) {
+            SandParticle* startingParticle = simulation.GetAt(x, y);
 
-        while (processQueue.size()) {
-            Position position = processQueue.back();
-            processQueue.pop_back();
+            // Only process particles that are occupied
+            if (!startingParticle->occupied || startingParticle->visited) continue;
 
-            // If the current position y is on the left border
-            if (position.y < y && position.x == 0) {
-                y = position.y;
-            }
+            bool touchesLeft = x == 0;
+            bool touchesRight = x == simulation.width - 1;
+            startingParticle->visited = true;
 
-            // Check borders to see if they have the same type
-            for (int i = 0; i < totalBorderPositions; i++) {
-                Position newPos = {position.x + borderPositions[i].x, position.y + borderPositions[i].y};
-                            
-                if (!simulation.ValidPosition(newPos.x, newPos.y)) continue;
+            // Vector of all visited positions
+            std::vector<Position>& visited = connectVisited;
+            visited.clear();
 
-                SandParticle* particle = simulation.GetAt(newPos.x, newPos.y);
-                if (!particle->occupied || particle->type != startingParticle->type || particle->visited) continue;
+            // Vector of positions that have yet to be processed
+            std::vector<Position>& processQueue = connectQueue;
+            processQueue.clear();
+            processQueue.push_back({x, y});
+            visited.push_back({x, y});
 
-                if (newPos.x == simulation.width - 1)
-                    connected = true;
+            while (processQueue.size()) {
+                Position position = processQueue.back();
+                processQueue.pop_back();
 
-                particle->visited = true;
-                processQueue.push_back(newPos);
-                visited.push_back(newPos);
-            }
-        }
+                // Check borders to see if they have the same type
+                for (int i = 0; i < totalBorderPositions; i++) {
+                    Position newPos = {position.x + borderPositions[i].x, position.y + borderPositions[i].y};
 
-        if (connected) {
-            if (stats.clears + 1 == level.requiredClears) {
-                levelUpAnim.start();
-                levelUpAnim.positions = visited;
-                stats.clears++;
-                CalculateScore();
-                SpawnBoardText("Level Up!", Colors::orange2, "Yay", Colors::orange4);
-                PlaySound(GetSound(Sounds::level_up));
-            } else {
-                connectionAnim.start();
-                connectionAnim.positions = visited;
-
-                const int totalComboSounds = 6;
-                const Sounds comboSounds[totalComboSounds] = {
-                    Sounds::clear_1,
-                    Sounds::clear_2,
-                    Sounds::clear_3,
-                    Sounds::clear_4,
-                    Sounds::clear_5,
-                    Sounds::clear_6,
-                };
-
-                PlaySound(GetSound(comboSounds[std::min(comboCount, totalComboSounds - 1)]));
+                    if (!simulation.ValidPosition(newPos.x, newPos.y)) continue;
+
+                    SandParticle* particle = simulation.GetAt(newPos.x, newPos.y);
+                    if (!particle->occupied || particle->type != startingParticle->type || particle->visited) continue;
+
+                    touchesLeft |= newPos.x == 0;
+                    touchesRight |= newPos.x == simulation.width - 1;
+
+                    particle->visited = true;
+                    processQueue.push_back(newPos);
+                    visited.push_back(newPos);
+                }
             }
-            verticalShakeTimer = 10;
-            horizontalShakeTimer = 10;
+
+            scanVisited.insert(scanVisited.end(), visited.begin(), visited.end());
+
+            if (touchesLeft && touchesRight)
+                OnSandConnected(visited);
         }
     }
+
+    // Only the sand this scan went through has to be unmarked, not the whole board
+    for (Position pos : scanVisited) {
+        simulation.GetAt(pos.x, pos.y)->visited = false;
+    }
+}
+
+// Starts clearing a group of sand that reaches from wall to wall
+void Game::OnSandConnected(const std::vector<Position>& positions) {
+    if (stats.clears + 1 == level.requiredClears) {
+        levelUpAnim.start();
+        levelUpAnim.positions = positions;
+        stats.clears++;
+        CalculateScore();
+        SpawnBoardText("Level Up!", Colors::orange2, "Yay", Colors::orange4);
+        QueueSound(Sounds::level_up);
+    } else {
+        connectionAnim.start();
+        connectionAnim.positions = positions;
+
+        const int totalComboSounds = 6;
+        const Sounds comboSounds[totalComboSounds] = {
+            Sounds::clear_1,
+            Sounds::clear_2,
+            Sounds::clear_3,
+            Sounds::clear_4,
+            Sounds::clear_5,
+            Sounds::clear_6,
+        };
+
+        QueueSound(comboSounds[std::min(comboCount, totalComboSounds - 1)]);
+    }
+    verticalShakeTimer = 10;
+    horizontalShakeTimer = 10;
 }
 
 void Game::UpdateConnectAnim() {
     connectionAnim.update(this);
 
     if (connectionAnim.isFinished()) {
+        // Collapse the sand above the clear now instead of letting it fall a row per step
+        if (app->settings.instantSettle)
+            simulation.Settle();
+
+        labelNextScan = true;
+
         int startScore = stats.score;
         CalculateScore();
 
@@ -596,7 +934,7 @@ void Game::UpdateConnectAnim() {
         comboCount++;
 
         const int maxComboNames = 6;
-        const std::string comboNames[maxComboNames] {
+        const std::string_view comboNames[maxComboNames] {
             "Congrats!",
             "Double Combo",
             "Triple Combo",
@@ -605,9 +943,9 @@ void Game::UpdateConnectAnim() {
             "Ultra Omega Jesus Combo"
         };
 
-        std::string largeString = comboNames[std::min(comboCount, maxComboNames) - 1];
+        std::string_view largeString = comboNames[std::min(comboCount, maxComboNames) - 1];
         Color largeColor = comboCount == 1 ? Colors::orange2 : Colors::orange4;
-        std::string smallString = "+" + std::to_string(stats.score - startScore);
+        std::string_view smallString = app->frameArena.Format("+%d", stats.score - startScore);
         Color smallColor = Colors::orange3;
 
         SpawnBoardText(largeString, largeColor, smallString, smallColor);
@@ -626,7 +964,7 @@ void Game::UpdateGameOverAnim() {
     if (!gameOverAnim.finished && gameOverTimer < totalDuration) {
         if (!gameOverAnim.active) {
             gameOverAnim.start();
-            PlaySound(GetSound(Sounds::game_over_1));
+            QueueSound(Sounds::game_over_1);
         }
 
         gameOverAnim.update(this);
@@ -636,102 +974,73 @@ void Game::UpdateGameOverAnim() {
     if (gameOverParticleAnim.active) {
         gameOverParticleAnim.update();
     } else if (!gameOverParticleAnim.finished) {
+        // Keeps the particle buffer reserved in Load
+        std::vector<FallingParticle> particles = std::move(gameOverParticleAnim.particles);
+        particles.clear();
+
         gameOverParticleAnim = FallingParticleAnim {
-            .particles = {},
+            .particles = std::move(particles),
             .boundingBox = Rectangle {0, 0, (float) simulation.width, (float) simulation.height},
             .collision = true,
         };
 
         gameOverParticleAnim.start();
-        PlaySound(GetSound(Sounds::game_over_2));
+        QueueSound(Sounds::game_over_2);
 
 
         // Add the existing particles to the animation
-        for (int simY = 0; simY < simulation.height; simY++) {
-            for (int simX = 0; simX < simulation.width; simX++) {
-                SandParticle* particle = simulation.GetAt(simX, simY);
-
-                if (particle != nullptr && particle->occupied) {
-                    Vector2 vel = {GetRandomValue(-3, 3) / 10.0f, 0};
-
-                    gameOverParticleAnim.particles.push_back(FallingParticle {
-                        .pos = {(float) simX, (float) simY},
-                        .vel = vel,
-                        .color = particle->color
-                    });
-                }
-            }
-        }
+        simulation.ForEachParticle([&](int simX, int simY, SandParticle& particle) {
+            Vector2 vel = {GetRandomValue(-3, 3) / 10.0f, 0};
+
+            gameOverParticleAnim.particles.push_back(FallingParticle {
+                .pos = {(float) simX, (float) simY},
+                .vel = vel,
+                .color = GetSandColor(particle)
+            });
+        });
 
         simulation.Clear();
     }
 
-    if (gameOverTimer > totalDuration) {
-        Transition* firstTransition = app->GetTransition("game-over-arrow");
-
-        if (firstTransition == nullptr) {
-            app->AddTransition<ArrowTransition>("game-over-arrow", Colors::orange0, 40, 260);
-        } else if (firstTransition->isFinished()) {
-            app->AddTransition<ReverseArrowTransition>("game-over-arrow-reversed", Colors::orange0, 40, 260);
+    // Tournament boards restart on their own without covering the screen
+    if (gameOverTimer > totalDuration && tournament) {
+        NewGame();
+    } else if (gameOverTimer > totalDuration && !app->transitions.IsActive(sceneTransition)) {
+        sceneTransition = app->transitions.Add(TransitionType::Arrow, Colors::orange0, 40, 260, [this]() {
+            app->transitions.Add(TransitionType::ReverseArrow, Colors::orange0, 40, 260);
             NewGame();
-        }
+        });
     }
 }
 
 void Game::UpdateLevelUpAnim() {
     if (!levelUpAnim.finished) {
         levelUpAnim.update(this);
-    } else {
-        Transition* transition = app->GetTransition("level-up-arrow");
-
-        if (transition == nullptr) {
-            app->AddTransition<ArrowTransition>("level-up-arrow", Colors::orange0, 40, 260);
-        } else if (transition->isFinished()) {
-            app->AddTransition<ReverseArrowTransition>("game-over-arrow", Colors::orange0, 40, 260);
+    } else if (tournament) {
+        levelIndex = std::min(levelIndex + 1, maxLevels - 1);
+        NewGame();
+    } else if (!app->transitions.IsActive(sceneTransition)) {
+        sceneTransition = app->transitions.Add(TransitionType::Arrow, Colors::orange0, 40, 260, [this]() {
+            app->transitions.Add(TransitionType::ReverseArrow, Colors::orange0, 40, 260);
             if (levelIndex < maxLevels - 1) {
                 levelIndex++;
                 NewGame();
             } else {
                 app->state = Application::States::Ending;
             }
-        }
+        });
     }
 }
 
 void Game::UpdateTextParticles() {
-    for (int i = textParticles.size() - 1; i > -1; i--) {
-        TextParticle &textParticle = textParticles[i];
-        textParticle.timer++;
-
-        if (textParticle.timer < textParticle.startDelay)
-            continue;
-
-        int fadeInTimer = std::min(textParticle.timer - textParticle.startDelay, textParticle.fadeInTime);
-        int fadeOutTimer = std::max(textParticle.timer - textParticle.fadeInTime, 0);
-
-        float fadeInOpacity = std::min(EaseCubicOut(fadeInTimer, textParticle.fadeInTime, 0, 1), 1.0f);
-        float fadeOutOpacity = EaseCubicIn(fadeOutTimer, textParticle.fadeOutTime, 0, 0.8f);
-        Color color = ColorAlpha(textParticle.color, fadeInOpacity - fadeOutOpacity);
-
-        Vector2 pos = {
-            textParticle.startPos.x,
-            textParticle.startPos.y - EaseCubicOut(fadeInTimer, textParticle.fadeInTime, 0, textParticle.ascendDistance) 
-                + EaseCubicIn(fadeOutTimer, textParticle.fadeOutTime, 0, textParticle.descendDistance)
-        };
-
-        app->font.RenderCentered(textParticle.text, pos, textParticle.size, color, true, false);
-    
-        if (textParticle.timer > textParticle.fadeInTime + textParticle.fadeOutTime) {
-            textParticles.erase(textParticles.begin() + i);
-        }
-    }
+    PROFILE_ZONE("Game::UpdateTextParticles");
+    textParticles.Update(app->frameArena);
 }
 
-void Game::SpawnBoardText(std::string largeString, Color largeColor, std::string smallString, Color smallColor) {
-    int yStart = std::min(std::max(boardRect.y + simulation.GetHighestPoint() * scale - 16, boardRect.y + 150), boardRect.y + boardRect.height - 16);
+void Game::SpawnBoardText(std::string_view largeString, Color largeColor, std::string_view smallString, Color smallColor) {
+    int yStart = std::min(std::max(boardRect.y + simulation.GetHighestPoint() * boardScale - 16, boardRect.y + 150), boardRect.y + boardRect.height - 16);
 
-    textParticles.push_back(TextParticle {
-        .text = largeString,
+    textParticles.Spawn(largeString, TextParticle {
         .startPos = {boardRect.x + boardRect.width / 2, (float) yStart},
         .size = 2,
         .color = largeColor,
@@ -741,8 +1050,7 @@ void Game::SpawnBoardText(std::string largeString, Color largeColor, std::string
         .descendDistance = 10,
         .startDelay = 0,
     });
-    textParticles.push_back(TextParticle {
-        .text = smallString,
+    textParticles.Spawn(smallString, TextParticle {
         .startPos = {boardRect.x + boardRect.width / 2, yStart + app->font.height * 2 + 6},
         .size = 1.8,
         .color = smallColor,
@@ -759,9 +1067,50 @@ void Game::CalculateScore() {
     scoreIncrement = std::max((stats.score - localScore) / 100 * 3, 3);
 }
 
+void Game::WriteSnapshot(std::ostream& out) {
+    out << "level: " << levelIndex + 1 << ", score: " << stats.score << ", clears: " << stats.clears << "/" << level.requiredClears
+        << ", combo: " << comboCount << ", game over: " << gameOver << "\n";
+    out << "text particles: " << textParticles.Count()
+        << ", game over particles: " << gameOverParticleAnim.particles.size()
+        << ", connection positions: " << connectionAnim.positions.size()
+        << ", level up positions: " << levelUpAnim.positions.size() << "\n";
+    out << "board " << simulation.width << "x" << simulation.height << " (run length encoded rows, '.' is air, digits are types):\n";
+
+    // Rows are written as count/cell pairs and empty rows are skipped
+    for (int y = 0; y < simulation.height; y++) {
+        std::string row;
+        int runLength = 0;
+        char runCell = 0;
+        bool empty = true;
+
+        for (int x = 0; x <= simulation.width; x++) {
+            char cell = 0;
+            if (x < simulation.width) {
+                SandParticle* particle = simulation.GetAt(x, y);
+                cell = particle->occupied ? (char) ('0' + particle->type) : '.';
+                empty &= !particle->occupied;
+            }
+
+            if (cell == runCell) {
+                runLength++;
+                continue;
+            }
+
+            if (runLength)
+                row += std::to_string(runLength) + runCell;
+
+            runCell = cell;
+            runLength = 1;
+        }
+
+        if (!empty)
+            out << y << ": " << row << "\n";
+    }
+}
+
 bool Game::IsShapeColliding() {
     int size = shapeTypes[currentShape.type].size;
-    const auto bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[currentShape.type].rotations[currentShape.rotation].bitmap;
 
     for (int i = 0; i < (signed) bitmap.size(); i++) {
         if (!bitmap[i]) continue;
@@ -770,8 +1119,12 @@ bool Game::IsShapeColliding() {
         pos.x *= tileSize;
         pos.y *= tileSize;
 
-        for (int y = tileSize - 1; y > -1; y--) {
-            for (int x = 0; x < tileSize; x++) {
+        for (int x = 0; x < tileSize; x++) {
+            // The whole column of the block is above the sand
+            if ((int) (cShapePos.y + pos.y + tileSize - 1) < simulation.ColumnTop(cShapePos.x + pos.x + x))
+                continue;
+
+            for (int y = tileSize - 1; y > -1; y--) {
                 SandParticle* particle = simulation.GetAt(cShapePos.x + pos.x + x, cShapePos.y + pos.y + y);
                 if (particle != nullptr && particle->occupied)
                     return true;
@@ -794,17 +1147,28 @@ bool Game::IsShapeInvalid() {
 }
 
 ShapeData Game::GenShape() {
-    return ShapeData {
-        .type = GetRandomValue(0, totalShapes - 1),
-        .color = GetRandomValue(0, level.maxColors - 1),
-        .style = GetRandomValue(0, totalStyles - 1),
+    ShapeData shape {
+        .type = Random(0, totalShapes - 1),
+        .color = Random(0, level.maxColors - 1),
+        .style = Random(0, totalStyles - 1),
         .rotation = 0
     };
+
+    // Levels that are all sand don't roll for a material, so their shapes come out the same as before
+    if (level.materials.Mixed()) {
+        shape.material = level.materials.Pick(Random(0, level.materials.Total() - 1));
+
+        int style = materialStyles[(int) shape.material];
+        if (style != -1)
+            shape.style = style;
+    }
+
+    return shape;
 }
 
 Rectangle GetShapeRect(ShapeData shape) {
     int size = shapeTypes[shape.type].size;
-    const auto bitmap = shapeTypes[shape.type].rotations[shape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[shape.type].rotations[shape.rotation].bitmap;
     Rectangle rect = {(float) size, (float) size, 0, 0};
 
     for (int i = 0; i < (signed) bitmap.size(); i++) {
@@ -832,34 +1196,34 @@ Vector2 IndexToPos(int index, int sideLength) {
     }; 
 }
 
-void DrawShape(ShapeData shape, Vector2 pos, float scale) {
+void DrawShape(ShapeData shape, Vector2 pos, float blockSize) {
     Texture2D &blocks = GetTexture(Textures::blocks);
     int size = shapeTypes[shape.type].size;
-    const auto bitmap = shapeTypes[shape.type].rotations[shape.rotation].bitmap;
+    const auto &bitmap = shapeTypes[shape.type].rotations[shape.rotation].bitmap;
 
     Rectangle src = {
-        (float) shape.style * tileSize,
-        (float) shape.color * tileSize,
-        tileSize,
-        tileSize
+        (float) shape.style * blockTextureSize,
+        (float) shape.color * blockTextureSize,
+        blockTextureSize,
+        blockTextureSize
     };
 
     for (int i = 0; i < (signed) bitmap.size(); i++) {
         if (!bitmap[i]) continue;
 
         Rectangle dest = {
-            pos.x + (i % size) * tileSize * scale,
-            pos.y + (float) std::floor(i / size) * tileSize * scale,
-            tileSize * scale,
-            tileSize * scale
+            pos.x + (i % size) * blockSize,
+            pos.y + (float) std::floor(i / size) * blockSize,
+            blockSize,
+            blockSize
         };
 
-        DrawTexturePro(blocks, src, dest, {0, 0}, 0, WHITE);
+        BatchTexturePro(blocks, src, dest, WHITE);
     }
 }
 
 void DrawBorder(Rectangle rect, int thickness, Color color) {
-    DrawRectangleLinesEx({
+    BatchRectangleLines({
         rect.x - thickness, 
         rect.y - thickness,  rect.width + thickness * 2, 
         rect.height + thickness * 2
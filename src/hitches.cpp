@@ -0,0 +1,91 @@
+#include <bit>
+#include <cmath>
+#include "hitches.h"
+
+/* ================ FrameHistogram ================ */
+
+int FrameHistogram::BucketIndex(long long value) {
+    if (value < subBucketCount * 2)
+        return (int) value;
+
+    int shift = std::bit_width((unsigned long long) value) - 1 - subBucketBits;
+    return std::min((shift + 1) * subBucketCount + (int) (value >> shift) - subBucketCount, totalBuckets - 1);
+}
+
+long long FrameHistogram::BucketValue(int index) {
+    if (index < subBucketCount * 2)
+        return index;
+
+    int shift = index / subBucketCount - 1;
+    long long subBucket = index % subBucketCount + subBucketCount;
+
+    // Highest value that still lands in this bucket
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void FrameHistogram::Record(long long value) {
+    value = std::max(value, 0LL);
+    counts[BucketIndex(value)]++;
+    count++;
+    max = std::max(max, value);
+}
+
+void FrameHistogram::Reset() {
+    std::fill(counts, counts + totalBuckets, 0);
+    count = 0;
+    max = 0;
+}
+
+long long FrameHistogram::ValueAtPercentile(double percentile) {
+    long long target = std::max((long long) std::ceil(percentile / 100.0 * count), 1LL);
+    long long total = 0;
+
+    for (int i = 0; i < totalBuckets; i++) {
+        total += counts[i];
+        if (total >= target)
+            return std::min(BucketValue(i), max);
+    }
+
+    return max;
+}
+
+/* ================ HitchDetector ================ */
+
+bool HitchDetector::Update() {
+    auto now = std::chrono::steady_clock::now();
+    frameIndex++;
+
+    if (!started) {
+        started = true;
+        lastFrame = now;
+        return false;
+    }
+
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(now - lastFrame).count();
+    lastFrame = now;
+    lastFrameMs = micros / 1000.0f;
+    histogram.Record(micros);
+
+    if (cooldown > 0) {
+        cooldown--;
+        return false;
+    }
+
+    if (budgetMs > 0 && lastFrameMs > budgetMs) {
+        cooldown = cooldownFrames;
+        return true;
+    }
+
+    return false;
+}
+
+void HitchDetector::PrintSummary() {
+    if (!histogram.Count())
+        return;
+
+    std::cout << "[Frames] " << histogram.Count() << " frames"
+        << ", p50: " << histogram.ValueAtPercentile(50) / 1000.0f << "ms"
+        << ", p99: " << histogram.ValueAtPercentile(99) / 1000.0f << "ms"
+        << ", p99.9: " << histogram.ValueAtPercentile(99.9) / 1000.0f << "ms"
+        << ", max: " << histogram.Max() / 1000.0f << "ms\n";
+}
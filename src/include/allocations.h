@@ -0,0 +1,24 @@
+#pragma once
+
+// Counts calls to every global operator new, aligned and nothrow ones included, when built
+// with -DENABLE_ALLOCATION_CHECK=ON. Application::Run exits with a failure on the first
+// steady state frame that allocates
+#ifdef ENABLE_ALLOCATION_CHECK
+
+long long GetAllocationCount();
+
+// Allocations made on this thread while one is alive aren't counted, for diagnostics like the
+// profiler overlay and hitch reports that run inside the checked frame but aren't part of it
+class AllocationCheckPause {
+public:
+    AllocationCheckPause();
+    ~AllocationCheckPause();
+};
+
+#define ALLOCATION_CHECK_PAUSE() AllocationCheckPause allocationCheckPause
+
+#else
+
+#define ALLOCATION_CHECK_PAUSE()
+
+#endif
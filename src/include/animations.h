@@ -15,6 +15,7 @@ struct Animation {
 
 struct ConnectionAnim : Animation {
     std::vector<Position> positions;
+    bool drawPixels = true;
 
     void update(Game* game);
     void reset() {
@@ -49,6 +50,7 @@ struct GameOverAnim : Animation {
 struct LevelUpAnimation : Animation {
     std::vector<Position> positions;
     Color tint;
+    bool drawPixels = true;
 
     void update(Game* game);
     void reset() {
@@ -66,6 +68,8 @@ struct FadeInCenterText : Animation {
     int fadeInTime;
     int stayTime;
     int fadeOutTime;
+    std::vector<Color> alphaColors;
 
     void update();
+    bool holding() {return stayTime < 0 && timer > fadeInTime;}
 };
\ No newline at end of file
@@ -3,6 +3,13 @@
 #include "common.h"
 #include "pixelfont.h"
 #include "transitions.h"
+#include "hitches.h"
+#include "arena.h"
+#include "jobs.h"
+#include "background.h"
+#include "pacing.h"
+#include "audio.h"
+#include "input.h"
 
 class Game;
 class Intro;
@@ -10,6 +17,7 @@ class Ending;
 
 const int screenWidth = 880;
 const int screenHeight = 640;
+const int targetFps = 60;
 
 namespace Colors {
     const Color orange0 = Color {139, 28, 3, 255};
@@ -24,6 +32,9 @@ class Screen {
 public:
     virtual void Load() = 0;
     virtual void Update() = 0;
+
+    // True when another Update would draw the same frame as the last one
+    virtual bool IsStatic() {return false;}
 };
 
 class Application {
@@ -37,38 +48,73 @@ public:
     struct Settings {
         bool music = true;
         bool sfx = true;
+        // Sounds and music are played on a thread of their own with this many voices per sound effect
+#ifdef PLATFORM_WEB
+        bool audioThread = false;
+#else
+        bool audioThread = true;
+#endif
+        int soundVoices = 4;
+        bool instantSettle = false;
+
+        // Delay before a held left or right starts moving after the first step, and how long auto
+        // repeat takes for a tick's worth of movement after that
+        float dasMs = 0;
+        float arrMs = 1000.0f / targetFps;
+        int sandFallSpeed = 1;
+
+        // Boards with at least this many cells find connected sand with the striped labeler on labelThreads threads
+        int labelerCells = 1 << 18;
+        int labelThreads = 0;
+        bool gpuSand = false;
+        float hitchBudgetMs = 50;
+        std::string hitchLogPath = "hitches.log";
+
+        // Tournament, more than one board tiles the screen with independent games
+        int boards = 1;
+        bool autopilot = false;
+        int boardThreads = 0;
+
+        // The background is drawn at this fraction of the screen size every this many frames
+        float backgroundScale = 0.5f;
+        int backgroundRefresh = 2;
+
+        // Static frames aren't redrawn, the loop sleeps and polls input idleFps times a second instead
+        bool idlePacing = true;
+        int idleFps = 20;
+        bool pauseUnfocused = true;
     };
 
     Game* game;
+    std::vector<Game*> boards;
     Intro* intro;
     Ending* ending;
     Music music;
     States state;
     Settings settings;
     PixelFont font;
+    FrameArena frameArena;
+    TransitionManager transitions;
+    Background background;
+    AudioSystem audio;
+    InputRecorder input;
     Application() = default;
     
     void Load();
     void Run();
     void Unload();
-    
-    template<typename Transition, typename... Args>
-    void AddTransition(std::string name, Args&&... args) {
-        transitions[name] = std::make_unique<Transition>(args...);
-    }
-
-    Transition* GetTransition(std::string name) {
-        auto pos = transitions.find(name);
-        if (pos != transitions.end()) {
-            return pos->second.get();
-        } else {
-            return nullptr;
-        }
-    }
+    void NewGames();
 
 private:
-    int time;
-    int iResoluationLoc;
-    int iTimeLoc;
-    std::map<std::string, std::unique_ptr<Transition>> transitions;
+    void WriteHitchReport();
+    bool FrameIsStatic();
+    void LoadTournament();
+    void UpdateTournament();
+
+    std::unique_ptr<JobSystem> jobs;
+    RenderTexture2D boardAtlas;
+    std::vector<Rectangle> atlasTiles;
+
+    HitchDetector hitchDetector;
+    FramePacer pacer;
 };
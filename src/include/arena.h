@@ -0,0 +1,36 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string_view>
+#include "common.h"
+
+// Bump allocator that is reset at the start of every frame. Anything allocated from it
+// is only valid until the end of the frame and is never destructed, so it is meant for
+// scratch strings and plain arrays
+class FrameArena {
+public:
+    FrameArena(size_t capacity = 16 * 1024);
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset();
+
+    template<typename T>
+    std::span<T> AllocateArray(size_t count) {
+        return {static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))), count};
+    }
+
+    // printf style formatting into the arena
+    std::string_view Format(const char* format, ...);
+
+    // Allocations this frame that didn't fit and went to the heap instead
+    size_t OverflowCount() const { return overflow.size(); }
+    size_t Capacity() const { return capacity; }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t offset = 0;
+
+    // Allocations that didn't fit, freed on the next reset
+    std::vector<std::unique_ptr<char[]>> overflow;
+};
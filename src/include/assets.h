@@ -16,6 +16,12 @@ inline std::map<Textures, const char*> texturePaths = {
     {Textures::font, "assets/image/font.png"},
 };
 
+// Textures whose decoded image is kept on the CPU, so their pixels never have to be read back from the GPU
+inline std::vector<Textures> cpuImages = {
+    Textures::blocks,
+    Textures::font,
+};
+
 // Sounds
 enum class Sounds {
     block_fall,
@@ -47,16 +53,19 @@ inline std::map<Sounds, const char*> soundPaths = {
 
 // Shaders
 enum class Shaders {
-    Heat
+    Heat,
+    Sand
 };
 
 #ifdef PLATFORM_WEB
     inline std::map<Shaders, const char*> shaderPaths = {
         {Shaders::Heat, "assets/shader/100/heat.fs"},
+        {Shaders::Sand, "assets/shader/100/sand.fs"},
     };
 #else
     inline std::map<Shaders, const char*> shaderPaths = {
         {Shaders::Heat, "assets/shader/330/heat.fs"},
+        {Shaders::Sand, "assets/shader/330/sand.fs"},
     };
 #endif
 
@@ -64,5 +73,6 @@ void LoadAssets();
 void UnloadAssets();
 
 Texture2D &GetTexture(Textures texture);
+Image &GetImage(Textures texture);
 Sound &GetSound(Sounds sound);
 Shader &GetShader(Shaders shader);
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "common.h"
+#include "assets.h"
+
+// Ring buffer for one producer thread and one consumer thread, neither of them ever
+// blocks on the other. Push fails when the ring is full
+template<typename T, unsigned int capacity>
+class SpscQueue {
+    static_assert((capacity & (capacity - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+    bool Push(T value) {
+        unsigned int tailIndex = tail.load(std::memory_order_relaxed);
+        if (tailIndex - head.load(std::memory_order_acquire) == capacity)
+            return false;
+
+        items[tailIndex & (capacity - 1)] = value;
+        tail.store(tailIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& value) {
+        unsigned int headIndex = head.load(std::memory_order_relaxed);
+        if (headIndex == tail.load(std::memory_order_acquire))
+            return false;
+
+        value = items[headIndex & (capacity - 1)];
+        head.store(headIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() {return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);}
+
+private:
+    T items[capacity];
+    alignas(64) std::atomic<unsigned int> head = 0;
+    alignas(64) std::atomic<unsigned int> tail = 0;
+};
+
+// Plays the sound effects and streams the music away from the game loop. Gameplay only
+// queues play requests, the audio thread plays them on a pool of aliases per sound so an
+// effect can overlap itself instead of restarting, and takes over the voice that started
+// longest ago once all of them are busy. Without a thread Update does the same work
+class AudioSystem {
+public:
+    // music can be null
+    void Load(int voicesPerSound, Music* music, bool threaded);
+    void Unload();
+
+    // Main thread only
+    void Play(Sounds sound);
+
+    // Called every frame, only does anything when there's no audio thread
+    void Update();
+
+    bool enabled = true;
+    long long droppedRequests = 0;
+
+private:
+    struct Voice {
+        Sound sound;
+        bool alias;
+        unsigned long long startedAt = 0;
+    };
+
+    void ThreadLoop();
+    void PlayRequests();
+    void PlayVoice(Sounds sound);
+
+    // Often enough that the music stream's buffers never run dry
+    const int updateIntervalMs = 10;
+
+    std::map<Sounds, std::vector<Voice>> voices;
+    SpscQueue<Sounds, 64> requests;
+    unsigned long long playCount = 0;
+    Music* music = nullptr;
+
+    std::thread thread;
+    std::atomic<bool> running = false;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+};
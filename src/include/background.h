@@ -0,0 +1,30 @@
+#pragma once
+#include "common.h"
+
+// Desert background with the heat distortion. The distortion samples a tileable noise
+// texture baked at startup, and the distorted background is drawn into a reduced
+// resolution render texture that is only refreshed every few frames or when the
+// source image changes, the screen just stretches that texture
+class Background {
+public:
+    void Load(float resolutionScale, int refreshInterval);
+    void Unload();
+
+    // Called once per frame, redraws the cache when it's due
+    void Update(Texture2D source);
+
+    // Adds the cached background to the current sprite batch, or draws it directly
+    void Draw();
+
+private:
+    void Refresh(Texture2D source);
+
+    RenderTexture2D cache;
+    Texture2D noiseTexture;
+    int refreshInterval;
+    int frames = 0;
+    int sinceRefresh = 0;
+    unsigned int lastSource = 0;
+    int timeLoc;
+    int noiseLoc;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <random>
+#include "game.h"
+#include "jobs.h"
+#include "config.h"
+
+struct BotSettings {
+    int games = 10;
+    int levelIndex = 0;
+    int settleSteps = 32;
+    bool instantSettle = false;
+    int sandFallSpeed = 1;
+    int maxPlacements = 200;
+    int threads = 0;
+    unsigned int seed = 1;
+};
+
+struct BotReport {
+    int games = 0;
+    long long placements = 0;
+    long long rollouts = 0;
+    long long clears = 0;
+    int completedLevels = 0;
+    double seconds = 0;
+};
+
+// Headless player used for load generation and as a balance check of levels.h.
+// Every candidate rotation and column of a shape is dropped on a copy of the
+// board, simulated and scored in parallel, and the best one is kept
+class Bot {
+public:
+    Bot(BotSettings settings);
+
+    BotReport Run();
+    void PrintReport(BotReport report);
+
+private:
+    struct Rollout {
+        Simulation board;
+        std::vector<Position> component;
+        std::vector<Position> processQueue;
+        bool valid;
+        int clears;
+        float score;
+    };
+
+    struct Candidate {
+        int rotation;
+        int x;
+    };
+
+    void PlayGame(std::mt19937& rng, BotReport& report);
+    int FindBestPlacement(Simulation& board, ShapeData shape);
+    void RunRollout(Rollout& rollout, Simulation& board, ShapeData shape, Candidate candidate);
+    bool DropShape(Simulation& board, ShapeData shape, int x);
+    int ResolveClears(Rollout& rollout);
+    float ScoreBoard(Simulation& board, int clears);
+    ShapeData GenShape(std::mt19937& rng);
+
+    BotSettings settings;
+    Level level;
+    JobSystem jobs;
+    std::vector<Candidate> candidates;
+    std::vector<Rollout> rollouts;
+};
+
+BotSettings LoadBotSettings(Config& config);
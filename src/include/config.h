@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include "common.h"
+
+// Startup options. Values come from an ini style file given with --config <path>
+// (key = value lines, [sections], ; and # comments are ignored) and are then
+// overridden by --key value pairs on the command line. A flag without a value is "1"
+class Config {
+public:
+    Config() = default;
+    Config(int argc, char** argv);
+
+    bool LoadFile(const std::string& path);
+
+    bool Has(const std::string& key);
+    std::string GetString(const std::string& key, const std::string& fallback);
+    int GetInt(const std::string& key, int fallback);
+    float GetFloat(const std::string& key, float fallback);
+    bool GetBool(const std::string& key, bool fallback);
+
+private:
+    std::map<std::string, std::string> values;
+};
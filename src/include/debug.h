@@ -1,5 +1,6 @@
 #pragma once
 #include "common.h"
+#include "profiler.h"
 
 inline void print() {
     std::cout << std::endl;
@@ -8,6 +8,7 @@ public:
 
     void Load() override;
     void Update() override;
+    bool IsStatic() override;
 
 private:
     Application* app;
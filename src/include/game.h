@@ -1,23 +1,33 @@
 #pragma once
+#include <random>
 #include "app.h"
 #include "shapes.h"
 #include "animations.h"
 #include "simulation.h"
 #include "levels.h"
+#include "config.h"
+#include "textparticles.h"
+#include "assets.h"
+#include "labeling.h"
 
 class Application;
 class Game;
 
+// Board Geometry, set once at startup by LoadBoardGeometry
+inline int tileSize = 8;
+inline int boardWidth = 10;
+inline int boardHeight = 17;
+inline float scale = 4;
+
 // UI Constants
-const int tileSize = 8;
-const int boardWidth = 10;
-const int boardHeight = 17;
+const int blockTextureSize = 8;
+const int panelTileSize = 32;
 const int panelBorderThickness = 6;
 const int panelPadding = 32;
 const int panelMarginSide = 16;
 const int panelMarginTop = 12;
-const float scale = 4;
 
+void LoadBoardGeometry(Config& config);
 Vector2 IndexToPos(int index, int sideLength);
 void DrawBorder(Rectangle rect, int thickness, Color color);
 
@@ -35,20 +45,15 @@ struct Timer {
     void reset() {timer = 0;}
 };
 
-struct TextParticle : Animation {
-    std::string text;
-    Vector2 startPos;
-    float size;
-    Color color;
-    int fadeInTime;
-    int fadeOutTime;
-    int ascendDistance;
-    int descendDistance;
-    int startDelay;
+enum class BoardControls {
+    Keyboard,   // WASD and the arrow keys
+    Wasd,
+    Arrows,
+    Autopilot   // Picks a random column and rotation for every shape
 };
 
 Rectangle GetShapeRect(ShapeData shape);
-void DrawShape(ShapeData shape, Vector2 pos, float scale);
+void DrawShape(ShapeData shape, Vector2 pos, float blockSize);
 
 class Game : Screen {
 public:
@@ -57,12 +62,30 @@ public:
 
     void Load() override;
     void Update() override;
+
+    // Nothing on the board moves: it's paused for focus and its animations have finished
+    bool IsStatic() override;
+
+    // Update is ReadInput, Tick, Draw and PlayQueuedSounds. Tick only touches this board
+    // so the tournament runs the boards' ticks in parallel
+    void ReadInput();
+    void Tick();
+    void Draw();
+    void PlayQueuedSounds();
+
+    // Main thread, after Tick. Reports how long the presses the tick acted on waited
+    void ReportInput();
+
+    // Tournament boards draw into a tile of a shared atlas and then a cell of the screen
+    void DrawTile(Rectangle tile);
+    void DrawTileOverlay(Texture2D atlas, Rectangle tile);
     
     void NewGame();
     void DrawBg();
     void DrawNextShape();
     void DrawInfoPanel();
     void DrawSandToTex();
+    void DrawSandWithShader();
     void MoveShape();
     void TryToCorrectShape();
     void RotateShape();
@@ -70,24 +93,55 @@ public:
     void CheckShapeCollision(Vector2 mouvement);
     void TurnShapeToSand();
     void FindConnectedSand();
+    void OnSandConnected(const std::vector<Position>& positions);
     void UpdateConnectAnim();
     void UpdateGameOverAnim();
     void UpdateLevelUpAnim();
     void UpdateTextParticles();
-    void SpawnBoardText(std::string largeString, Color largeColor, std::string smallString, Color smallColor);
+    void SpawnBoardText(std::string_view largeString, Color largeColor, std::string_view smallString, Color smallColor);
     void CalculateScore();
 
+    void WriteSnapshot(std::ostream& out);
+    Color GetSandColor(SandParticle& particle);
+
     bool IsShapeColliding();
     bool IsShapeInvalid();
     ShapeData GenShape();
 
     Rectangle boardRect;
+    float boardScale;
     Rectangle nextShapeRect;
     Rectangle infoPanelRect;
     RenderTexture2D boardTex;
     Simulation simulation;
 
+    // Set before Load
+    int boardIndex = 0;
+    bool tournament = false;
+    BoardControls controls = BoardControls::Keyboard;
+    Rectangle viewport = {0, 0, screenWidth, screenHeight};
+
 private:
+    void DrawBoardContents();
+    void OffsetLayout(Vector2 offset);
+    void QueueSound(Sounds sound);
+    void UpdateAutopilot();
+    void ResetInput();
+    int Random(int min, int max);
+
+    std::mt19937 rng;
+    GameInput input;
+
+    InputReader inputReader;
+    double consumedMovePress = 0;
+    double consumedRotatePress = 0;
+    bool paused;
+    bool focusPaused = false;   // The window lost focus, boards that play themselves keep going
+    Vector2 screenShake;
+    std::vector<Sounds> queuedSounds;
+    int autopilotX;
+    int autopilotRotation;
+
     int sinceSandUpdate;
     int bgAnimationTimer;
     int startDelay;
@@ -100,15 +154,39 @@ private:
     bool gameOver = false;
     Timer bgAnimation;
     Image blocksImg;
+    std::vector<Color> blockPixels;
+    std::vector<SandParticle> blockParticles;
     Application* app;
 
+    // Shader sand rendering
+    bool gpuSand;
+    Texture2D sandPlaneTex;
+    std::vector<unsigned char> sandPlanes;
+    int sandAtlasLoc;
+    int sandAtlasSizeLoc;
+    int sandTintLoc;
+    int sandFlashLoc;
+
     // Animations
     int gameOverTimer;
+    TransitionHandle sceneTransition;
     ConnectionAnim connectionAnim;
     LevelUpAnimation levelUpAnim;
     FallingParticleAnim gameOverParticleAnim;
     GameOverAnim gameOverAnim;
-    std::vector<TextParticle> textParticles;
+    TextParticleSystem textParticles;
+
+    // Scratch buffers for FindConnectedSand, kept so the search doesn't allocate. It only
+    // scans again once the simulation's generation changed
+    std::vector<Position> connectVisited;
+    std::vector<Position> connectQueue;
+    std::vector<Position> scanVisited;
+    unsigned int scannedGeneration = 0;
+
+    // Full board labeling for bulk edits and big boards
+    SandLabeler labeler;
+    std::unique_ptr<JobSystem> labelJobs;
+    bool labelNextScan = true;
     
     // Shape
     ShapeData currentShape;
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include "common.h"
+
+// Log-linear histogram in the style of HdrHistogram. Values below 64 get their own
+// bucket and every power of two above that is split into 32 linear buckets, so any
+// recorded value is kept to within ~3% over the whole range
+class FrameHistogram {
+public:
+    void Record(long long value);
+    void Reset();
+    long long ValueAtPercentile(double percentile);
+    long long Count() {return count;}
+    long long Max() {return max;}
+
+private:
+    static const int subBucketBits = 5;
+    static const int subBucketCount = 1 << subBucketBits;
+    static const int totalBuckets = subBucketCount * 40;
+
+    static int BucketIndex(long long value);
+    static long long BucketValue(int index);
+
+    long long counts[totalBuckets] = {};
+    long long count = 0;
+    long long max = 0;
+};
+
+// Keeps a histogram of frame times in microseconds and flags frames that go over budget
+class HitchDetector {
+public:
+    // Call once per frame, returns true when the last frame was a hitch
+    bool Update();
+    void PrintSummary();
+
+    // Call when the loop stopped drawing for a while so the gap isn't recorded as a frame
+    void Restart() {started = false;}
+
+    float budgetMs = 50;
+    float lastFrameMs = 0;
+    int frameIndex = 0;
+    FrameHistogram histogram;
+
+private:
+    // Don't flood the log when a whole sequence of frames is slow
+    const int cooldownFrames = 60;
+
+    std::chrono::steady_clock::time_point lastFrame;
+    int cooldown = 0;
+    bool started = false;
+};
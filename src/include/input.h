@@ -0,0 +1,123 @@
+#pragma once
+#include <span>
+#include "common.h"
+#include "hitches.h"
+
+enum class InputAction {
+    Left,
+    Right,
+    Down,
+    Rotate,
+    HoldRotation,
+    None
+};
+
+const int totalInputActions = 5;
+
+struct KeyBinding {
+    int key;
+    InputAction action;
+};
+
+// Keys a board reacts to, read from the input recorder on the main thread before the boards tick
+struct GameInput {
+    // How many ticks worth of movement, from how long the key was held since the last
+    // frame. A press always moves at least a whole tick
+    float left;
+    float right;
+    float down;
+    bool rotate;        // A press is waiting, one is used up per tick
+    bool holdRotation;  // Rotates without checking for collisions
+
+    // When the presses being acted on happened, 0 when there aren't any
+    double movePressTime;
+    double rotatePressTime;
+};
+
+struct KeyEvent {
+    int key;
+    bool pressed;   // Released otherwise
+    double time;    // InputRecorder::Now when it was seen
+};
+
+// Ring of key presses and releases with the time they were seen. On desktop a GLFW key
+// callback is chained in front of raylib's and WaitUntil waits for the next frame on the
+// window's event queue, so events are timed when they arrive and a key let go before the
+// frame ends still counts. Elsewhere the watched keys are sampled
+// once a frame
+class InputRecorder {
+public:
+    static const int capacity = 256;
+
+    void Load(std::vector<int> keys);
+    void Unload();
+
+    // True when WaitUntil paces the frames, raylib's own frame limit is turned off then
+    bool PumpsEvents() {return callbackInstalled;}
+
+    // Waits on the window's events until time when there's a key callback, without one
+    // raylib's frame limit paces the loop and this returns right away
+    void WaitUntil(double time);
+
+    // Blocks for up to seconds, on desktop it returns as soon as the window gets an event. Without
+    // the key callback it sleeps and then polls raylib's input itself
+    void WaitForEvents(double seconds);
+
+    // Records the watched keys that changed since the last frame, only without a key callback
+    void SampleFrame();
+
+    void Record(int key, bool pressed, double time);
+    static double Now();
+
+    // Readers keep their own index into the ring, starting from End. One that fell more than
+    // capacity events behind has to skip ahead to Oldest
+    unsigned long long End() const {return written;}
+    unsigned long long Oldest() const {return written > capacity ? written - capacity : 0;}
+    const KeyEvent& At(unsigned long long index) const {return events[index % capacity];}
+
+    // Time from a press to the end of the logic tick that moved or rotated the shape for it
+    void RecordLatency(double seconds);
+    void PrintSummary();
+
+private:
+    KeyEvent events[capacity];
+    unsigned long long written = 0;
+    bool callbackInstalled = false;
+    std::vector<int> watchedKeys;
+    std::vector<bool> keyStates;
+    FrameHistogram latency;
+};
+
+// One board's view of the recorder. Every frame Read turns the events since the last one
+// into a GameInput, rotation presses wait in a small queue until a tick uses them up
+class InputReader {
+public:
+    // Starts reading from the recorder's end, with every key up and nothing queued
+    void Reset(const InputRecorder& recorder, std::span<const KeyBinding> keyBindings, double now);
+    GameInput Read(const InputRecorder& recorder, double now);
+
+    // Called by the tick that rotated for the oldest queued press
+    void ConsumeRotation();
+
+    // Delay before a held left or right keeps moving after its first step, the time auto
+    // repeat takes for a tick's worth of movement after that, and the length of a tick
+    float dasMs = 0;
+    float arrMs = 1000.0f / 60;
+    float tickMs = 1000.0f / 60;
+
+    static const int maxPendingRotations = 2;
+
+    // Presses that couldn't be acted on for this long are dropped
+    static constexpr double rotationBufferTime = 0.2;
+
+private:
+    InputAction KeyAction(int key);
+
+    std::vector<KeyBinding> bindings;
+    unsigned long long cursor = 0;
+    double lastReadTime = 0;
+    int keysDown[totalInputActions] = {};
+    double pressedAt[totalInputActions] = {};
+    int pendingRotations = 0;
+    double rotationPressTimes[maxPendingRotations] = {};
+};
@@ -16,6 +16,7 @@ private:
 
     int timer;
     int afterParticleTimer;
+    TransitionHandle transition;
     RenderTexture2D renderTexture;
     FallingParticleAnim particleAnim;
     Application* app;
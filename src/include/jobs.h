@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "common.h"
+
+// Small fixed size thread pool. The calling thread takes part in the work, so
+// a pool created with one thread runs everything inline
+class JobSystem {
+public:
+    JobSystem(int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Calls job(i) for every i in [0, count) and waits until all of them have finished
+    void ParallelFor(int count, std::function<void(int)> job);
+    int ThreadCount();
+
+private:
+    void WorkerLoop();
+    void RunJobs();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    std::function<void(int)> currentJob;
+    std::atomic<int> nextIndex = 0;
+    int jobCount = 0;
+    int busyWorkers = 0;
+    int generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "common.h"
+#include "simulation.h"
+#include "jobs.h"
+
+// Two pass connected component labeling of the sand by type over runs of same type
+// particles instead of single cells. The board is cut into stripes of rows that are
+// labeled on separate threads, then runs that touch across the stripe boundaries are
+// merged. Everything is reserved for the worst case on the first call and kept, so
+// labeling doesn't allocate after that
+class SandLabeler {
+public:
+    // Labels the whole board, with jobs null every stripe is labeled on this thread
+    void Label(const Simulation& simulation, JobSystem* jobs);
+
+    // Components touching both walls, ordered by their lowest cell on the left wall, bottom first
+    const std::vector<int>& SpanningLabels() {return spanning;}
+
+    // Replaces positions with the cells of a component
+    void CollectPositions(int label, std::vector<Position>& positions);
+
+private:
+    struct Run {
+        int y;
+        int start;
+        int end;    // Inclusive
+        unsigned char type;
+    };
+
+    struct Stripe {
+        int top;
+        int bottom;
+        int offset;                 // Id of the stripe's first run
+        std::vector<Run> runs;
+        std::vector<int> rowStarts; // First run of every row and one past the last run
+    };
+
+    void BuildRuns(const Simulation& simulation, Stripe& stripe);
+    void MergeRows(const Stripe& upperStripe, int upperRow, const Stripe& lowerStripe, int lowerRow);
+    int Find(int id);
+    void Union(int a, int b);
+
+    // Stripes are at least this many rows so merging them stays cheap
+    const int minStripeRows = 16;
+
+    int width = 0;
+    std::vector<Stripe> stripes;
+    std::vector<int> parent;
+    std::vector<int> leftWallRow;
+    std::vector<bool> rightWall;
+    std::vector<int> spanning;
+};
@@ -1,10 +1,12 @@
 #pragma once
+#include "materials.h"
 
 struct Level {
     float fallSpeed;
     float horizontalSpeed;
     int maxColors;
     int requiredClears;
+    MaterialMix materials;  // What new shapes are made of
 };
 
 const int maxLevels = 6;
@@ -27,23 +29,27 @@ const Level levels[maxLevels] = {
         .horizontalSpeed = 2.2,
         .maxColors = 4,
         .requiredClears = 12,
+        .materials = {{4, 1, 0, 0}},
     },
     Level {
         .fallSpeed = 2,
         .horizontalSpeed = 2.4,
         .maxColors = 4,
         .requiredClears = 16,
+        .materials = {{4, 1, 1, 0}},
     },
     Level {
         .fallSpeed = 2.4,
         .horizontalSpeed = 2.5,
         .maxColors = 4,
         .requiredClears = 24,
+        .materials = {{4, 1, 1, 1}},
     },
     Level {
         .fallSpeed = 3,
         .horizontalSpeed = 2.6,
         .maxColors = 5,
         .requiredClears = 32,
+        .materials = {{3, 2, 1, 1}},
     }
 };
\ No newline at end of file
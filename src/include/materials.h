@@ -0,0 +1,74 @@
+#pragma once
+
+enum class Material : unsigned char {
+    Sand,
+    HeavySand,  // Sinks through liquid and doesn't slide off slopes
+    Liquid,     // Spreads sideways when it can't fall
+    Rock,       // Stays where it was placed
+};
+
+const int totalMaterials = 4;
+
+// Movement rule of a material, read at compile time by Simulation::StepRun so every
+// material gets its own kernel without any per particle branching on the material
+template<Material material>
+struct MaterialRule {
+    static constexpr bool falls = true;
+    static constexpr bool slides = true;    // Moves diagonally down when blocked below
+    static constexpr bool flows = false;    // Moves sideways when it can't fall or slide
+    static constexpr bool sinks = false;    // Swaps places with liquid below
+    static constexpr unsigned char spreadDistance = 0;  // Sideways moves after falling before a flowing particle rests
+};
+
+template<>
+struct MaterialRule<Material::HeavySand> {
+    static constexpr bool falls = true;
+    static constexpr bool slides = false;
+    static constexpr bool flows = false;
+    static constexpr bool sinks = true;
+    static constexpr unsigned char spreadDistance = 0;
+};
+
+template<>
+struct MaterialRule<Material::Liquid> {
+    static constexpr bool falls = true;
+    static constexpr bool slides = true;
+    static constexpr bool flows = true;
+    static constexpr bool sinks = false;
+    static constexpr unsigned char spreadDistance = 32;
+};
+
+template<>
+struct MaterialRule<Material::Rock> {
+    static constexpr bool falls = false;
+    static constexpr bool slides = false;
+    static constexpr bool flows = false;
+    static constexpr bool sinks = false;
+    static constexpr unsigned char spreadDistance = 0;
+};
+
+// Block style shapes of each material are drawn with so they can be told apart, -1 picks a random style
+const int materialStyles[totalMaterials] = {-1, 3, 1, 4};
+
+// Relative odds of every material for a new shape
+struct MaterialMix {
+    int weights[totalMaterials] = {1, 0, 0, 0};
+
+    int Total() const {
+        int total = 0;
+        for (int weight : weights) total += weight;
+        return total;
+    }
+
+    // False when every shape is sand, callers skip rolling for a material then
+    bool Mixed() const {return Total() > weights[0];}
+
+    // Roll is between 0 and Total() - 1
+    Material Pick(int roll) const {
+        for (int i = 0; i < totalMaterials; i++) {
+            if (roll < weights[i]) return (Material) i;
+            roll -= weights[i];
+        }
+        return Material::Sand;
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "common.h"
+#include "input.h"
+
+// Skips frames that would look the same as the last one. The loop reports after every
+// drawn frame whether another update would change anything, once idleAfter of those
+// in a row were static it stops drawing and instead sleeps between input polls at
+// idleFps, keeping the last frame on screen until there is input or the frame changes.
+// Waiting never polls raylib's input, so a key that wakes the loop still counts as
+// pressed in the next drawn frame
+class FramePacer {
+public:
+    // Call after every drawn frame
+    void FrameDrawn(bool frameStatic);
+
+    // Waits for up to one idle tick, returns true when there was input
+    bool WaitForInput(InputRecorder& recorder);
+
+    bool Idle() {return enabled && staticFrames >= idleAfter;}
+    void Wake() {staticFrames = 0;}
+
+    bool enabled = true;
+    int idleFps = 20;
+    // Both buffers have to hold the static frame before swaps can stop
+    int idleAfter = 2;
+    long long idleTicks = 0;
+
+private:
+    int staticFrames = 0;
+};
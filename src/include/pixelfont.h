@@ -1,6 +1,14 @@
 #pragma once
+#include <span>
+#include <string_view>
 #include "common.h"
 
+// Letter of a laid out string, the offset is in unscaled font pixels
+struct PixelGlyph {
+    Rectangle source;
+    Vector2 offset;
+};
+
 class PixelFont {
 public:
     int spaceSize;
@@ -10,15 +18,42 @@ public:
     Texture2D texture;
     std::map<char, Rectangle> letters;
 
+    // Copy of the texture's pixels for drawing text on the CPU
+    std::vector<Color> pixels;
+
     PixelFont() = default;
-    PixelFont(Texture2D text, std::string chars, int _spaceSize, Color splitColor = BLACK);
+    PixelFont(Texture2D text, Image image, std::string chars, int _spaceSize, Color splitColor = BLACK);
 
-    int Measure(std::string text);
+    int Measure(std::string_view text);
     void SetValues(int _letterDistance, int _lineOffset);
 
-    void Render(std::string text, Vector2 pos, float size, Color color);
-    void RenderCentered(std::string text, Vector2 pos, float size, Color color, bool centerX=false, bool centerY=false);
-    void RenderCenteredRec(Rectangle region, std::string text, float size, Color color);
+    void Render(std::string_view text, Vector2 pos, float size, Color color);
+    void RenderCentered(std::string_view text, Vector2 pos, float size, Color color, bool centerX=false, bool centerY=false);
+    void RenderCenteredRec(Rectangle region, std::string_view text, float size, Color color);
     
-    void RenderColored(std::vector<std::string> texts, Vector2 pos, float size, std::vector<Color> colors);
+    // Lays out text once so it can be drawn many times without looking up letters,
+    // returns the width like Measure
+    int Layout(std::string_view text, std::vector<PixelGlyph>& glyphs);
+    void RenderLayout(std::span<const PixelGlyph> glyphs, Vector2 pos, float size, Color color);
+
+    void RenderColored(std::span<const std::string> texts, Vector2 pos, float size, std::span<const Color> colors);
+
+    // Calls function(x, y, color) for every visible pixel of the text at size 1, with the same
+    // colors Render would draw, without going through the GPU
+    template<typename Function>
+    void Rasterize(std::string_view text, Vector2 pos, Color tint, Function function) {
+        std::vector<PixelGlyph> glyphs;
+        Layout(text, glyphs);
+
+        for (const PixelGlyph &glyph : glyphs) {
+            for (int y = 0; y < glyph.source.height; y++) {
+                for (int x = 0; x < glyph.source.width; x++) {
+                    Color color = pixels[(glyph.source.y + y) * texture.width + glyph.source.x + x];
+                    if (color.a == 0) continue;
+
+                    function(pos.x + glyph.offset.x + x, pos.y + glyph.offset.y + y, ColorTint(color, tint));
+                }
+            }
+        }
+    }
 };
\ No newline at end of file
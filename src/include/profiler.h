@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include "common.h"
+
+// Scoped timing zones. Build with -DENABLE_PROFILER=ON to turn them on, otherwise
+// every macro below expands to nothing
+#ifdef ENABLE_PROFILER
+
+namespace Profiler {
+    struct ZoneEvent {
+        int zone;
+        long long start;
+        long long end;
+    };
+
+    struct ZoneStats {
+        const char* name;
+        float min;
+        float avg;
+        float p99;
+        float last;
+    };
+
+    int RegisterZone(const char* name);
+    void Record(int zone, long long start, long long end);
+
+    // Drains every thread's events and pushes this frame's totals into the rolling window
+    void EndFrame();
+
+    // F3 toggles the overlay, F4 writes profile.json
+    void UpdateOverlay();
+    bool ExportChromeTrace(const char* path);
+    std::vector<ZoneStats> GetStats();
+
+    inline long long Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class ScopedZone {
+    public:
+        ScopedZone(int zone) : zone(zone), start(Now()) {}
+        ~ScopedZone() {Record(zone, start, Now());}
+
+    private:
+        int zone;
+        long long start;
+    };
+}
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) \
+    static const int PROFILER_CONCAT(profileZoneId, __LINE__) = Profiler::RegisterZone(name); \
+    Profiler::ScopedZone PROFILER_CONCAT(profileZone, __LINE__)(PROFILER_CONCAT(profileZoneId, __LINE__))
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+#define PROFILE_OVERLAY() Profiler::UpdateOverlay()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_END_FRAME()
+#define PROFILE_OVERLAY()
+
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include "common.h"
+
+// Directory linked shader programs are cached in, empty to always compile from source
+inline std::string shaderCacheDir = "shadercache";
+
+// LoadShader(0, fsPath) that first tries a program binary cached for the same source,
+// raylib version and driver. Compiled programs are written to the cache when the driver
+// can hand out their binary. Only desktop GL has program binaries, elsewhere this just compiles
+Shader LoadShaderCached(const char* fsPath);
@@ -1,11 +1,13 @@
 #pragma once
 #include <vector>
+#include "materials.h"
 
 struct ShapeData {
     int type;
     int color;
     int style;
     int rotation;
+    Material material = Material::Sand;
 };
 
 struct Rotation {
@@ -1,31 +1,146 @@
+#pragma once
 #include <memory>
 #include "common.h"
+#include "materials.h"
 
 struct SandParticle {
     bool occupied = false;
-    Color color;
-    int type;
+    unsigned char type;
+    // Pixel of the blocks texture the particle was taken from, which is also its color
+    unsigned char atlasX = 0;
+    unsigned char atlasY = 0;
     bool visited = false;
+    Material material = Material::Sand;
+    // Cells fallen last step, only used when the simulation's maxFallSpeed is above 1
+    unsigned char velocity = 0;
+    // Sideways moves liquid has left before it rests, refilled whenever it moves down
+    unsigned char spread = 0;
 };
 
+const int chunkShift = 6;
+const int chunkSize = 1 << chunkShift;
+const int chunkMask = chunkSize - 1;
+
+// A chunkSize x chunkSize tile of the board. Rows are local to the chunk and
+// minRow/maxRow only ever grow until the chunk is empty, so they bound the sand
+// without having to be exact
+struct SandChunk {
+    SandParticle particles[chunkSize * chunkSize];
+    int occupied = 0;
+    int minRow = chunkSize;
+    int maxRow = -1;
+};
+
+// Cells changed since the last TakeDirtyBox, inclusive. Empty when maxX < minX
+struct DirtyBox {
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+
+    bool Empty() const {return maxX < minX;}
+};
+
+// The board is stored as chunks that are allocated when sand is first placed in
+// them and released once they are empty, so memory and the cost of a step scale
+// with the amount of sand instead of the size of the board. Released chunks are
+// kept aside and handed out again so sand moving between chunks doesn't allocate
 class Simulation {
 public:
     Simulation() = default;
     Simulation(int width, int height);
+    Simulation(const Simulation& other);
+    Simulation(Simulation&& other) = default;
+    Simulation& operator=(const Simulation& other);
+    Simulation& operator=(Simulation&& other) = default;
 
     void Step();
+    int Settle();
 
+    // Positions inside chunks that aren't allocated return a shared empty particle,
+    // only SetAt can place sand
     SandParticle* GetAt(int x, int y);
     void SetAt(int x, int y, SandParticle value);
+    void SetRow(int x, int y, const SandParticle* values, int count);
     void Clear();
     void ResetVisited();
     int IndexAt(int x, int y);
     int GetHighestPoint();
     bool ValidPosition(int x, int y);
 
-    int width;
-    int height;
+    // Particles from (x, y) to the end of its chunk's row or the board, null when that chunk
+    // is empty. Doesn't write anything so other threads can read the board through it
+    const SandParticle* RowSpan(int x, int y, int& count) const {
+        const SandChunk* chunk = chunks[(y >> chunkShift) * chunksX + (x >> chunkShift)].get();
+        count = std::min(chunkSize - (x & chunkMask), width - x);
+        return chunk != nullptr && chunk->occupied ? &chunk->particles[(y & chunkMask) * chunkSize + (x & chunkMask)] : nullptr;
+    }
+
+    // Row of the highest particle in a column, or height when the column is empty
+    int ColumnTop(int x) {return x >= 0 && x < width ? columnTops[x] : height;}
+    int AllocatedChunks();
+
+    // Goes up whenever a particle is placed, removed or moved
+    unsigned int Generation() {return generation;}
+    DirtyBox TakeDirtyBox();
+
+    // Calls function(x, y, particle) for every occupied particle, skipping empty chunks
+    template<typename Function>
+    void ForEachParticle(Function function) {
+        for (int cy = 0; cy < chunksY; cy++) {
+            for (int cx = 0; cx < chunksX; cx++) {
+                SandChunk* chunk = chunks[cy * chunksX + cx].get();
+                if (chunk == nullptr || !chunk->occupied) continue;
+
+                int xEnd = std::min(chunkSize, width - cx * chunkSize);
+                for (int row = chunk->minRow; row <= chunk->maxRow; row++) {
+                    for (int column = 0; column < xEnd; column++) {
+                        SandParticle &particle = chunk->particles[row * chunkSize + column];
+                        if (particle.occupied)
+                            function(cx * chunkSize + column, cy * chunkSize + row, particle);
+                    }
+                }
+            }
+        }
+    }
+
+    int width = 0;
+    int height = 0;
+
+    // Falling particles speed up by a cell every step up to this many cells, 1 moves everything a cell at a time
+    int maxFallSpeed = 1;
 
 private:
-    std::unique_ptr<SandParticle[]> sandBuffer;
+    template<Material material>
+    int StepRun(SandChunk* chunk, int row, int y, int x, int xEnd);
+
+    int FallDistance(int x, int y, int speed);
+
+    SandChunk* ChunkAt(int x, int y) {return chunks[(y >> chunkShift) * chunksX + (x >> chunkShift)].get();}
+    bool ChunkRowEmpty(int cy);
+    void ReleaseEmptyChunks();
+    void ReleaseChunk(std::unique_ptr<SandChunk>& chunk);
+    std::unique_ptr<SandChunk> NewChunk();
+    void FindColumnTop(int x, int y);
+    void MarkDirty(int minX, int minY, int maxX, int maxY);
+
+    int chunksX = 0;
+    int chunksY = 0;
+    std::vector<std::unique_ptr<SandChunk>> chunks;
+    // Empty chunks kept around for the next one that's needed, the rest are freed so memory
+    // follows the amount of sand instead of staying at its peak. Enough to hold a whole
+    // board of the default size, so games on it never allocate chunks after Clear
+    static constexpr int maxSpareChunks = 8;
+    std::vector<std::unique_ptr<SandChunk>> spareChunks;
+    SandParticle air;
+    int steps = 0;
+
+    unsigned int generation = 0;
+    DirtyBox dirty = {0, 0, -1, -1};
+
+    // Kept up to date by SetAt. The highest point is only recalculated from the
+    // columns when the column it came from loses its top particle
+    std::vector<int> columnTops;
+    int highestPoint = 0;
+    bool highestDirty = false;
 };
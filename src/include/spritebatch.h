@@ -0,0 +1,27 @@
+#pragma once
+#include "common.h"
+
+// Draw order of the batch. Quads are sorted by layer first, so anything that has
+// to be drawn over something else needs a higher layer
+enum class BatchLayer {
+    Background,
+    Panel,
+    Board,      // Tournament board tiles, under the text drawn on them
+    Sprite
+};
+
+// Quads drawn between BeginSpriteBatch and EndSpriteBatch are collected and submitted
+// with rlgl grouped by layer, shader and texture, so each group is a single draw call.
+// Outside of a batch every function draws immediately like its raylib counterpart
+void BeginSpriteBatch();
+void EndSpriteBatch();
+
+// Shader used by the quads that follow, Shader{} for the default one
+void SetBatchShader(Shader shader);
+
+void BatchTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Color tint, BatchLayer layer = BatchLayer::Sprite);
+void BatchRectangle(Rectangle rect, Color color, BatchLayer layer = BatchLayer::Panel);
+void BatchRectangleLines(Rectangle rect, float thickness, Color color, BatchLayer layer = BatchLayer::Panel);
+
+// Amount of draw calls the last batch was submitted with
+int GetBatchDrawCalls();
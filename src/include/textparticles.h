@@ -0,0 +1,53 @@
+#pragma once
+#include "common.h"
+#include "pixelfont.h"
+#include "arena.h"
+
+struct TextParticle {
+    int text;   // Set by TextParticleSystem::Spawn
+    Vector2 startPos;
+    float size;
+    Color color;
+    int fadeInTime;
+    int fadeOutTime;
+    int ascendDistance;
+    int descendDistance;
+    int startDelay;
+    int timer = 0;
+};
+
+// Floating board text. Strings are interned and laid out once when they are first
+// spawned into a fixed table, once it's full a layout no particle uses any more is
+// replaced, so spawning never allocates. Particles live in a fixed pool that expires by
+// swapping with the last one and all of them are drawn as a single sprite batch
+class TextParticleSystem {
+public:
+    static const int capacity = 1024;
+
+    void Load(PixelFont* font);
+    void Spawn(std::string_view text, TextParticle particle);
+    void Update(FrameArena& arena);
+    void Clear();
+
+    int Count() {return particles.size();}
+
+private:
+    static const int maxLayouts = 64;
+    static const int maxTextLength = 32;    // Longer strings are cut off
+
+    struct TextLayout {
+        char text[maxTextLength];
+        int length = 0;
+        std::vector<PixelGlyph> glyphs;     // Reserved for maxTextLength glyphs
+        int width = 0;
+    };
+
+    // Index of the text's layout, -1 when the table is full of layouts that are still shown
+    int Intern(std::string_view text);
+
+    PixelFont* font;
+    std::vector<TextParticle> particles;
+    std::vector<TextLayout> layouts;
+    int usedLayouts = 0;
+    int nextReplaced = 0;
+};
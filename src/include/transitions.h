@@ -1,41 +1,51 @@
 #pragma once
+#include <array>
+#include <functional>
 #include "common.h"
-#include "easing.h"
+#include "easetables.h"
 
-class Transition {
-public:
-    virtual void Draw() = 0;
-    virtual bool isFinished() = 0;
+enum class TransitionType {
+    Arrow,          // Sweeps in from the left and covers the screen
+    ReverseArrow    // Uncovers the screen from the left
 };
 
-class ArrowTransition : public Transition {
-public:
-    ArrowTransition(Color color, float duration, int arrowOffset, EaseFunction easingFunction=EaseCubicInOut) 
-        : color(color), duration(duration), arrowOffset(arrowOffset), timer(0), easingFunction(easingFunction) {};
-
-    void Draw() override;
-    bool isFinished() override;
-
-private:
-    Color color;
-    float duration;
-    int timer;
-    int arrowOffset;
-    EaseFunction easingFunction;
+// Refers to a transition in the pool, stale once the transition finishes and its slot is reused
+struct TransitionHandle {
+    int index = -1;
+    unsigned int generation = 0;
 };
 
-class ReverseArrowTransition : public Transition {
+// Fixed size pool of full screen transitions. Finished transitions call their callback
+// and free their slot, and all of the active ones are drawn as a single batch of triangles
+class TransitionManager {
 public:
-    ReverseArrowTransition(Color color, float duration, int arrowOffset, EaseFunction easingFunction=EaseCubicInOut) 
-        : color(color), duration(duration), arrowOffset(arrowOffset), timer(0), easingFunction(easingFunction) {};
+    static const int capacity = 8;
 
-    void Draw() override;
-    bool isFinished() override;
+    TransitionHandle Add(TransitionType type, Color color, int duration, int arrowOffset,
+        std::function<void()> onFinished = {}, EaseCurve curve = EaseCurve::CubicInOut);
+
+    bool IsActive(TransitionHandle handle);
+    int ActiveCount();
+
+    // Advances and draws every transition, called once per frame after the screen is drawn
+    void Update();
 
 private:
-    Color color;
-    float duration;
-    int timer;
-    int arrowOffset;
-    EaseFunction easingFunction;
+    struct Slot {
+        TransitionType type;
+        Color color;
+        int duration;
+        int timer;
+        int arrowOffset;
+        EaseCurve curve;
+        const float* easeTable;
+        std::function<void()> onFinished;
+        unsigned int generation = 0;
+        bool active = false;
+    };
+
+    void AppendGeometry(Slot& slot);
+    float Ease(Slot& slot, float startValue, float totalChange);
+
+    std::array<Slot, capacity> slots;
 };
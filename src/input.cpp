@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "input.h"
+
+#if defined(PLATFORM_WEB)
+#include <emscripten/emscripten.h>
+#endif
+
+#if defined(PLATFORM_DESKTOP)
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+// raylib handles GLFW's key callback itself, ours is put in front of it and passes every event on
+static InputRecorder* callbackRecorder = nullptr;
+static GLFWkeyfun raylibKeyCallback = nullptr;
+
+// raylib's key codes are GLFW's
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (callbackRecorder != nullptr && (action == GLFW_PRESS || action == GLFW_RELEASE))
+        callbackRecorder->Record(key, action == GLFW_PRESS, InputRecorder::Now());
+
+    if (raylibKeyCallback != nullptr)
+        raylibKeyCallback(window, key, scancode, action, mods);
+}
+
+#endif
+
+void InputRecorder::Load(std::vector<int> keys) {
+    watchedKeys = std::move(keys);
+    keyStates.assign(watchedKeys.size(), false);
+
+#if defined(PLATFORM_DESKTOP)
+    callbackRecorder = this;
+    raylibKeyCallback = glfwSetKeyCallback((GLFWwindow*) GetWindowHandle(), KeyCallback);
+    callbackInstalled = true;
+#endif
+}
+
+void InputRecorder::Unload() {
+#if defined(PLATFORM_DESKTOP)
+    if (callbackInstalled) {
+        glfwSetKeyCallback((GLFWwindow*) GetWindowHandle(), raylibKeyCallback);
+        callbackRecorder = nullptr;
+        callbackInstalled = false;
+    }
+#endif
+}
+
+void InputRecorder::WaitUntil(double time) {
+#if defined(PLATFORM_DESKTOP)
+    // Blocks until an event arrives or the frame is due, so the key callback runs as soon as
+    // a key changes. Only the event queue is pumped, raylib's previous key states are left
+    // alone so IsKeyPressed still compares whole frames
+    while (callbackInstalled) {
+        double remaining = time - Now();
+        if (remaining <= 0)
+            return;
+
+        glfwWaitEventsTimeout(remaining);
+    }
+#endif
+}
+
+void InputRecorder::WaitForEvents(double seconds) {
+#if defined(PLATFORM_DESKTOP)
+    if (callbackInstalled) {
+        glfwWaitEventsTimeout(seconds);
+        return;
+    }
+#endif
+
+#if defined(PLATFORM_WEB)
+    // Hands control back to the browser through ASYNCIFY, events are only delivered while it has it
+    emscripten_sleep((unsigned int) (seconds * 1000));
+#else
+    // A plain sleep, raylib's WaitTime spins through the end of every wait
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+#endif
+
+    // Nothing else pumps events while idle, without this IsKeyDown, the mouse and the window
+    // state never change and the loop can't wake up again
+    PollInputEvents();
+}
+
+void InputRecorder::SampleFrame() {
+    if (callbackInstalled)
+        return;
+
+    double now = Now();
+
+    for (int i = 0; i < (signed) watchedKeys.size(); i++) {
+        int key = watchedKeys[i];
+        bool down = IsKeyDown(key);
+
+        if (down != keyStates[i]) {
+            Record(key, down, now);
+            keyStates[i] = down;
+        }
+    }
+}
+
+void InputRecorder::Record(int key, bool pressed, double time) {
+    events[written % capacity] = KeyEvent {key, pressed, time};
+    written++;
+}
+
+double InputRecorder::Now() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void InputRecorder::RecordLatency(double seconds) {
+    latency.Record((long long) (std::max(seconds, 0.0) * 1000000));
+}
+
+void InputRecorder::PrintSummary() {
+    if (!latency.Count())
+        return;
+
+    std::cout << "[Input] " << latency.Count() << " presses"
+        << ", latency p50: " << latency.ValueAtPercentile(50) / 1000.0f << "ms"
+        << ", p99: " << latency.ValueAtPercentile(99) / 1000.0f << "ms"
+        << ", max: " << latency.Max() / 1000.0f << "ms\n";
+}
+
+void InputReader::Reset(const InputRecorder& recorder, std::span<const KeyBinding> keyBindings, double now) {
+    bindings.assign(keyBindings.begin(), keyBindings.end());
+    cursor = recorder.End();
+    lastReadTime = now;
+    pendingRotations = 0;
+
+    for (int i = 0; i < totalInputActions; i++) {
+        keysDown[i] = 0;
+    }
+}
+
+GameInput InputReader::Read(const InputRecorder& recorder, double now) {
+    double windowStart = lastReadTime;
+    double window = std::max(now - windowStart, 0.000001);
+    lastReadTime = now;
+
+    // Time every action was held since the last frame, left and right only count once auto shift kicks in
+    double heldTime[totalInputActions] = {};
+    bool pressed[totalInputActions] = {};
+    double movePressTime = 0;
+    double countedUntil = windowStart;
+
+    auto countHeldTime = [&](double until) {
+        for (int i = 0; i < totalInputActions; i++) {
+            if (!keysDown[i]) continue;
+
+            bool shifts = i == (int) InputAction::Left || i == (int) InputAction::Right;
+            double from = std::max(countedUntil, pressedAt[i] + (shifts ? dasMs / 1000 : 0));
+            heldTime[i] += std::max(until - from, 0.0);
+        }
+        countedUntil = until;
+    };
+
+    cursor = std::max(cursor, recorder.Oldest());
+    for (; cursor < recorder.End(); cursor++) {
+        const KeyEvent &event = recorder.At(cursor);
+        InputAction action = KeyAction(event.key);
+        if (action == InputAction::None) continue;
+
+        int index = (int) action;
+        double time = std::clamp(event.time, windowStart, now);
+        countHeldTime(time);
+
+        if (!event.pressed) {
+            keysDown[index] = std::max(keysDown[index] - 1, 0);
+            continue;
+        }
+
+        if (keysDown[index]++ == 0)
+            pressedAt[index] = time;
+        pressed[index] = true;
+
+        if (action == InputAction::Rotate && pendingRotations < maxPendingRotations) {
+            rotationPressTimes[pendingRotations++] = time;
+        } else if ((action == InputAction::Left || action == InputAction::Right) && movePressTime == 0) {
+            movePressTime = time;
+        }
+    }
+
+    countHeldTime(now);
+
+    while (pendingRotations && now - rotationPressTimes[0] > rotationBufferTime) {
+        ConsumeRotation();
+    }
+
+    // Auto repeat moves a tick's worth every arr milliseconds instead of every tick
+    float repeatScale = tickMs / arrMs;
+    auto amount = [&](InputAction action, float scale) {
+        int index = (int) action;
+        float held = heldTime[index] / window * scale;
+        return pressed[index] ? std::max(held, 1.0f) : held;
+    };
+
+    return GameInput {
+        .left = amount(InputAction::Left, repeatScale),
+        .right = amount(InputAction::Right, repeatScale),
+        .down = amount(InputAction::Down, 1),
+        .rotate = pendingRotations > 0,
+        .holdRotation = keysDown[(int) InputAction::HoldRotation] > 0 || pressed[(int) InputAction::HoldRotation],
+        .movePressTime = movePressTime,
+        .rotatePressTime = pendingRotations ? rotationPressTimes[0] : 0
+    };
+}
+
+void InputReader::ConsumeRotation() {
+    if (!pendingRotations)
+        return;
+
+    pendingRotations--;
+    for (int i = 0; i < pendingRotations; i++) {
+        rotationPressTimes[i] = rotationPressTimes[i + 1];
+    }
+}
+
+InputAction InputReader::KeyAction(int key) {
+    for (const KeyBinding &binding : bindings) {
+        if (binding.key == key)
+            return binding.action;
+    }
+    return InputAction::None;
+}
@@ -5,6 +5,7 @@
 
 const std::string text = "Made by Jake";
 const std::vector<std::string> coloredText = {"Made by ", "Jake"};
+const Color coloredTextColors[] = {WHITE, Colors::orange3};
 
 void Intro::Load() {
     timer = 0;
@@ -24,7 +25,7 @@ void Intro::Update() {
     if (!particleAnim.active) {
         if (timer > textFadeInDelay) {
             BeginTextureMode(renderTexture);
-            app->font.RenderColored(coloredText, {0, 0}, 1, {WHITE, Colors::orange3});
+            app->font.RenderColored(coloredText, {0, 0}, 1, coloredTextColors);
             EndTextureMode();
 
             Rectangle source {
@@ -58,8 +59,6 @@ void Intro::Update() {
 }
 
 void Intro::SpawnParticles(Rectangle destOffset, float scale) {
-    Image image = LoadImageFromTexture(renderTexture.texture);
-    
     particleAnim = FallingParticleAnim {
         .particles = {},
         .boundingBox = {},
@@ -70,32 +69,31 @@ void Intro::SpawnParticles(Rectangle destOffset, float scale) {
         .horizontalDrag = 0.001,
     };
 
-    for (int x = 0; x < renderTexture.texture.width; x++) {
-        for (int y = 0; y < renderTexture.texture.height; y++) {
-            Color color = GetImageColor(image, x, renderTexture.texture.height - y - 1);
-
-            if (color.a > 0) {
-                particleAnim.particles.push_back(FallingParticle {
-                    .pos = {destOffset.x + x * scale, destOffset.y + y * scale},
-                    .vel = {GetRandomValue(-200, 200) / 100.0f, GetRandomValue(-200, 400) / 100.0f},
-                    .color = color,
-                    .size = (int) scale
-                });
-            }
-        }
+    // Rasterize the same text the render texture holds instead of reading it back from the GPU
+    float x = 0;
+    for (int i = 0; i < (signed) coloredText.size(); i++) {
+        app->font.Rasterize(coloredText[i], {x, 0}, coloredTextColors[i], [&](int x, int y, Color color) {
+            particleAnim.particles.push_back(FallingParticle {
+                .pos = {destOffset.x + x * scale, destOffset.y + y * scale},
+                .vel = {GetRandomValue(-200, 200) / 100.0f, GetRandomValue(-200, 400) / 100.0f},
+                .color = color,
+                .size = (int) scale
+            });
+        });
+
+        x += app->font.Measure(coloredText[i]);
     }
 
     particleAnim.start();
 }
 
 void Intro::UpdateTransitions() {
-    Transition* first = app->GetTransition("intro-arrow");
+    if (app->transitions.IsActive(transition))
+        return;
 
-    if (first == nullptr) {
-        app->AddTransition<ArrowTransition>("intro-arrow", Colors::orange0, 40, 260);
-    } else if (first->isFinished()) {
-        app->AddTransition<ReverseArrowTransition>("intro-arrow-reversed", Colors::orange0, 40, 260);
+    transition = app->transitions.Add(TransitionType::Arrow, Colors::orange0, 40, 260, [this]() {
+        app->transitions.Add(TransitionType::ReverseArrow, Colors::orange0, 40, 260);
         app->state = Application::States::Game;
-        app->game->NewGame();
-    }
+        app->NewGames();
+    });
 }
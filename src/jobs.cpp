@@ -0,0 +1,78 @@
+#include "jobs.h"
+
+JobSystem::JobSystem(int threadCount) {
+    if (threadCount <= 0)
+        threadCount = std::max((int) std::thread::hardware_concurrency(), 1);
+
+    // The thread calling ParallelFor counts as one of the threads
+    for (int i = 0; i < threadCount - 1; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::ParallelFor(int count, std::function<void(int)> job) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = std::move(job);
+        jobCount = count;
+        nextIndex = 0;
+        busyWorkers = (int) workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    RunJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] {return busyWorkers == 0;});
+    currentJob = nullptr;
+}
+
+int JobSystem::ThreadCount() {
+    return (int) workers.size() + 1;
+}
+
+void JobSystem::WorkerLoop() {
+    int lastGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] {return stopping || generation != lastGeneration;});
+            if (stopping) return;
+            lastGeneration = generation;
+        }
+
+        RunJobs();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            done.notify_one();
+    }
+}
+
+void JobSystem::RunJobs() {
+    int index;
+    while ((index = nextIndex.fetch_add(1)) < jobCount) {
+        currentJob(index);
+    }
+}
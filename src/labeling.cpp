@@ -0,0 +1,182 @@
+#include <algorithm>
+#include "labeling.h"
+#include "debug.h"
+
+void SandLabeler::Label(const Simulation& simulation, JobSystem* jobs) {
+    PROFILE_ZONE("SandLabeler::Label");
+
+    width = simulation.width;
+    int height = simulation.height;
+    int threads = jobs != nullptr ? jobs->ThreadCount() : 1;
+    int stripeCount = std::clamp(height / minStripeRows, 1, threads);
+
+    stripes.resize(stripeCount);
+    for (int i = 0; i < stripeCount; i++) {
+        stripes[i].top = height * i / stripeCount;
+        stripes[i].bottom = height * (i + 1) / stripeCount;
+
+        // At most a run per cell, reserved for that so a busier board never allocates
+        int rows = stripes[i].bottom - stripes[i].top;
+        stripes[i].runs.reserve(rows * width);
+        stripes[i].rowStarts.reserve(rows + 1);
+    }
+
+    parent.reserve(width * height);
+    leftWallRow.reserve(width * height);
+    rightWall.reserve(width * height);
+    spanning.reserve(height);
+
+    auto buildStripe = [this, &simulation](int i) {BuildRuns(simulation, stripes[i]);};
+    if (jobs != nullptr) {
+        jobs->ParallelFor(stripeCount, buildStripe);
+    } else {
+        for (int i = 0; i < stripeCount; i++) buildStripe(i);
+    }
+
+    int totalRuns = 0;
+    for (Stripe &stripe : stripes) {
+        stripe.offset = totalRuns;
+        totalRuns += stripe.runs.size();
+    }
+
+    parent.resize(totalRuns);
+    for (int i = 0; i < totalRuns; i++) {
+        parent[i] = i;
+    }
+
+    // First pass inside the stripes, each stripe only links ids of its own runs so they don't race
+    auto mergeStripe = [this](int i) {
+        Stripe &stripe = stripes[i];
+        for (int y = stripe.top + 1; y < stripe.bottom; y++) {
+            MergeRows(stripe, y - 1, stripe, y);
+        }
+    };
+    if (jobs != nullptr) {
+        jobs->ParallelFor(stripeCount, mergeStripe);
+    } else {
+        for (int i = 0; i < stripeCount; i++) mergeStripe(i);
+    }
+
+    // Then across the stripe boundaries
+    for (int i = 1; i < stripeCount; i++) {
+        MergeRows(stripes[i - 1], stripes[i - 1].bottom - 1, stripes[i], stripes[i].top);
+    }
+
+    // Second pass, every run points straight at its component and the walls are noted on the root
+    leftWallRow.assign(totalRuns, -1);
+    rightWall.assign(totalRuns, false);
+
+    for (Stripe &stripe : stripes) {
+        for (int i = 0; i < (signed) stripe.runs.size(); i++) {
+            const Run &run = stripe.runs[i];
+            int root = Find(stripe.offset + i);
+            parent[stripe.offset + i] = root;
+
+            if (run.start == 0)
+                leftWallRow[root] = std::max(leftWallRow[root], run.y);
+            if (run.end == width - 1)
+                rightWall[root] = true;
+        }
+    }
+
+    spanning.clear();
+    for (int id = 0; id < totalRuns; id++) {
+        if (parent[id] == id && leftWallRow[id] != -1 && rightWall[id])
+            spanning.push_back(id);
+    }
+
+    std::sort(spanning.begin(), spanning.end(), [this](int a, int b) {
+        return leftWallRow[a] > leftWallRow[b];
+    });
+}
+
+void SandLabeler::CollectPositions(int label, std::vector<Position>& positions) {
+    positions.clear();
+
+    for (Stripe &stripe : stripes) {
+        for (int i = 0; i < (signed) stripe.runs.size(); i++) {
+            if (parent[stripe.offset + i] != label) continue;
+
+            const Run &run = stripe.runs[i];
+            for (int x = run.start; x <= run.end; x++) {
+                positions.push_back({x, run.y});
+            }
+        }
+    }
+}
+
+void SandLabeler::BuildRuns(const Simulation& simulation, Stripe& stripe) {
+    stripe.runs.clear();
+    stripe.rowStarts.clear();
+
+    for (int y = stripe.top; y < stripe.bottom; y++) {
+        stripe.rowStarts.push_back(stripe.runs.size());
+        Run* open = nullptr;
+
+        int count;
+        for (int x = 0; x < width; x += count) {
+            const SandParticle* particles = simulation.RowSpan(x, y, count);
+            if (particles == nullptr) {
+                open = nullptr;
+                continue;
+            }
+
+            for (int i = 0; i < count; i++) {
+                const SandParticle &particle = particles[i];
+
+                if (!particle.occupied) {
+                    open = nullptr;
+                } else if (open != nullptr && open->type == particle.type) {
+                    open->end = x + i;
+                } else {
+                    stripe.runs.push_back(Run {y, x + i, x + i, particle.type});
+                    open = &stripe.runs.back();
+                }
+            }
+        }
+    }
+
+    stripe.rowStarts.push_back(stripe.runs.size());
+}
+
+// Walks two neighbouring rows' runs in order of x and links the ones of the same type that overlap
+void SandLabeler::MergeRows(const Stripe& upperStripe, int upperRow, const Stripe& lowerStripe, int lowerRow) {
+    int upper = upperStripe.rowStarts[upperRow - upperStripe.top];
+    int upperEnd = upperStripe.rowStarts[upperRow - upperStripe.top + 1];
+    int lower = lowerStripe.rowStarts[lowerRow - lowerStripe.top];
+    int lowerEnd = lowerStripe.rowStarts[lowerRow - lowerStripe.top + 1];
+
+    while (upper < upperEnd && lower < lowerEnd) {
+        const Run &a = upperStripe.runs[upper];
+        const Run &b = lowerStripe.runs[lower];
+
+        if (a.type == b.type && a.start <= b.end && b.start <= a.end)
+            Union(upperStripe.offset + upper, lowerStripe.offset + lower);
+
+        if (a.end < b.end) {
+            upper++;
+        } else {
+            lower++;
+        }
+    }
+}
+
+int SandLabeler::Find(int id) {
+    while (parent[id] != id) {
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+// The lower id becomes the root so a stripe's components stay inside its own range of ids
+void SandLabeler::Union(int a, int b) {
+    a = Find(a);
+    b = Find(b);
+
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
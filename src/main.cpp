@@ -1,8 +1,44 @@
 #include "app.h"
+#include "bot.h"
+#include "config.h"
+#include "shadercache.h"
+
+int main(int argc, char** argv) {
+    Config config(argc, argv);
+    LoadBoardGeometry(config);
+
+    if (config.GetBool("bot", false)) {
+        Bot bot(LoadBotSettings(config));
+        bot.PrintReport(bot.Run());
+        return 0;
+    }
 
-int main() {
     Application* app = new Application();
 
+    shaderCacheDir = config.GetString("shader-cache", shaderCacheDir);
+
+    app->settings.music = config.GetBool("music", app->settings.music);
+    app->settings.sfx = config.GetBool("sfx", app->settings.sfx);
+    app->settings.audioThread = config.GetBool("audio-thread", app->settings.audioThread);
+    app->settings.soundVoices = std::max(config.GetInt("sound-voices", app->settings.soundVoices), 1);
+    app->settings.dasMs = std::max(config.GetFloat("das", app->settings.dasMs), 0.0f);
+    app->settings.arrMs = std::max(config.GetFloat("arr", app->settings.arrMs), 1.0f);
+    app->settings.instantSettle = config.GetBool("instant-settle", app->settings.instantSettle);
+    app->settings.labelerCells = config.GetInt("label-cells", app->settings.labelerCells);
+    app->settings.labelThreads = config.GetInt("label-threads", app->settings.labelThreads);
+    app->settings.sandFallSpeed = std::clamp(config.GetInt("sand-fall-speed", app->settings.sandFallSpeed), 1, 255);
+    app->settings.gpuSand = config.GetBool("gpu-sand", app->settings.gpuSand);
+    app->settings.hitchBudgetMs = config.GetFloat("hitch-budget", app->settings.hitchBudgetMs);
+    app->settings.hitchLogPath = config.GetString("hitch-log", app->settings.hitchLogPath);
+    app->settings.boards = std::max(config.GetInt("boards", app->settings.boards), 1);
+    app->settings.autopilot = config.GetBool("autopilot", app->settings.autopilot);
+    app->settings.boardThreads = config.GetInt("board-threads", app->settings.boardThreads);
+    app->settings.backgroundScale = config.GetFloat("bg-scale", app->settings.backgroundScale);
+    app->settings.backgroundRefresh = config.GetInt("bg-refresh", app->settings.backgroundRefresh);
+    app->settings.idlePacing = config.GetBool("idle-pacing", app->settings.idlePacing);
+    app->settings.idleFps = std::max(config.GetInt("idle-fps", app->settings.idleFps), 1);
+    app->settings.pauseUnfocused = config.GetBool("pause-unfocused", app->settings.pauseUnfocused);
+
     app->Load();
     app->Run();
     app->Unload();
@@ -0,0 +1,26 @@
+#include "pacing.h"
+
+void FramePacer::FrameDrawn(bool frameStatic) {
+    staticFrames = frameStatic ? staticFrames + 1 : 0;
+}
+
+bool FramePacer::WaitForInput(InputRecorder& recorder) {
+    unsigned long long keyEvents = recorder.End();
+
+    recorder.WaitForEvents(1.0 / std::max(idleFps, 1));
+    recorder.SampleFrame();
+    idleTicks++;
+
+    // With the key callback raylib's previous input states only move on in EndDrawing, so these
+    // compare against the last drawn frame. Otherwise they compare against the poll that just
+    // ran, and the loop wakes before the next poll can take a press out of raylib's key queue
+    bool input = recorder.End() != keyEvents || IsWindowResized();
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++) {
+        input |= IsMouseButtonPressed(button);
+    }
+
+    Vector2 mouseDelta = GetMouseDelta();
+    input |= mouseDelta.x != 0 || mouseDelta.y != 0 || GetMouseWheelMove() != 0;
+
+    return input;
+}
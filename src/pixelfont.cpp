@@ -1,7 +1,8 @@
 #include <cmath>
 #include "pixelfont.h"
+#include "spritebatch.h"
 
-PixelFont::PixelFont(Texture2D text, std::string chars, int _spaceSize, Color splitColor) {
+PixelFont::PixelFont(Texture2D text, Image image, std::string chars, int _spaceSize, Color splitColor) {
     texture = text;
     spaceSize = _spaceSize;
 
@@ -10,12 +11,15 @@ PixelFont::PixelFont(Texture2D text, std::string chars, int _spaceSize, Color sp
     int characterIndex = 0;
     int begin = 0;
     int current = 1;
-    Image image = LoadImageFromTexture(text);
+
+    Color* colors = LoadImageColors(image);
+    pixels.assign(colors, colors + image.width * image.height);
+    UnloadImageColors(colors);
 
     while (current <= text.width && characterIndex < (signed) chars.size()) {
         bool isSplitColor = true;
         if (current < text.width) {
-            Color pixelColor = GetImageColor(image, current, 0);
+            Color pixelColor = pixels[current];
             isSplitColor = pixelColor.r == splitColor.r && pixelColor.g == splitColor.g && pixelColor.b == splitColor.b && pixelColor.a == splitColor.a;
         }
 
@@ -35,7 +39,7 @@ PixelFont::PixelFont(Texture2D text, std::string chars, int _spaceSize, Color sp
     }
 }
 
-int PixelFont::Measure(std::string text) {
+int PixelFont::Measure(std::string_view text) {
     int width = 0;
     for (char character : text) {
         if (character == '\n') {
@@ -44,8 +48,8 @@ int PixelFont::Measure(std::string text) {
             width += spaceSize;
         } else if (character == '\t') {
             width += spaceSize * 4;
-        } else if (letters.find(character) != letters.end()) {
-            width += letters[character].width + letterDistance;
+        } else if (auto letter = letters.find(character); letter != letters.end()) {
+            width += letter->second.width + letterDistance;
         }
     }
     return width;
@@ -56,7 +60,7 @@ void PixelFont::SetValues(int _letterDistance, int _lineOffset) {
     lineOffset = _lineOffset;
 }
 
-void PixelFont::Render(std::string text, Vector2 pos, float size, Color color) {
+void PixelFont::Render(std::string_view text, Vector2 pos, float size, Color color) {
     for (char character : text) {
         if (character == '\n') {
             pos.x = 0;
@@ -65,16 +69,16 @@ void PixelFont::Render(std::string text, Vector2 pos, float size, Color color) {
             pos.x += spaceSize * size;
         } else if (character == '\t') {
             pos.x += spaceSize * 4 * size;
-        } else if (letters.find(character) != letters.end()) {
-            Rectangle source = letters[character];
+        } else if (auto letter = letters.find(character); letter != letters.end()) {
+            Rectangle source = letter->second;
             Rectangle dest = {std::floor(pos.x), std::floor(pos.y), std::floor(source.width * size), std::floor(source.height * size)};
-            DrawTexturePro(texture, source, dest, {0, 0}, 0, color);
+            BatchTexturePro(texture, source, dest, color);
             pos.x += (source.width + letterDistance) * size;
         }
     }
 }
 
-void PixelFont::RenderCentered(std::string text, Vector2 pos, float size, Color color, bool centerX, bool centerY) {
+void PixelFont::RenderCentered(std::string_view text, Vector2 pos, float size, Color color, bool centerX, bool centerY) {
     if (centerX)
         pos.x -= (Measure(text) * size) / 2;
     if (centerY)
@@ -83,16 +87,51 @@ void PixelFont::RenderCentered(std::string text, Vector2 pos, float size, Color
     Render(text, pos, size, color);
 }
 
-void PixelFont::RenderCenteredRec(Rectangle region, std::string text, float size, Color color) {
+void PixelFont::RenderCenteredRec(Rectangle region, std::string_view text, float size, Color color) {
     Render(text, {
         region.x + region.width / 2 - Measure(text) * size / 2, 
         region.y + region.height / 2 - height * size / 2 - (size - 1)
     }, size, color);
 }
 
-void PixelFont::RenderColored(std::vector<std::string> texts, Vector2 pos, float size, std::vector<Color> colors) {
+void PixelFont::RenderColored(std::span<const std::string> texts, Vector2 pos, float size, std::span<const Color> colors) {
     for (int i = 0; i < (signed) std::min(texts.size(), colors.size()); i++) {
         Render(texts[i], pos, size, colors[i]);
         pos.x += Measure(texts[i]) * size;
     }
 }
+
+int PixelFont::Layout(std::string_view text, std::vector<PixelGlyph>& glyphs) {
+    glyphs.clear();
+    Vector2 offset = {0, 0};
+    int width = 0;
+
+    for (char character : text) {
+        if (character == '\n') {
+            offset.x = 0;
+            offset.y += texture.height + lineOffset;
+        } else if (character == ' ') {
+            offset.x += spaceSize;
+        } else if (character == '\t') {
+            offset.x += spaceSize * 4;
+        } else if (auto letter = letters.find(character); letter != letters.end()) {
+            glyphs.push_back(PixelGlyph {letter->second, offset});
+            offset.x += letter->second.width + letterDistance;
+        }
+        width = offset.x;
+    }
+
+    return width;
+}
+
+void PixelFont::RenderLayout(std::span<const PixelGlyph> glyphs, Vector2 pos, float size, Color color) {
+    for (const PixelGlyph &glyph : glyphs) {
+        Rectangle dest = {
+            std::floor(pos.x + glyph.offset.x * size),
+            std::floor(pos.y + glyph.offset.y * size),
+            std::floor(glyph.source.width * size),
+            std::floor(glyph.source.height * size)
+        };
+        BatchTexturePro(texture, glyph.source, dest, color);
+    }
+}
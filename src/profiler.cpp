@@ -0,0 +1,238 @@
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace Profiler {
+    const int maxZones = 64;
+    const int windowSize = 240;
+    const int ringCapacity = 4096;
+    const int maxTraceEvents = 1 << 16;
+
+    // Single producer (the owning thread), single consumer (EndFrame on the main thread)
+    struct ThreadBuffer {
+        ZoneEvent events[ringCapacity];
+        std::atomic<unsigned int> head = 0;
+        std::atomic<unsigned int> tail = 0;
+        std::atomic<int> dropped = 0;
+        int threadIndex;
+    };
+
+    struct TraceEvent {
+        ZoneEvent event;
+        int threadIndex;
+    };
+
+    struct Zone {
+        const char* name;
+        float window[windowSize];
+        int windowCount = 0;
+        int windowIndex = 0;
+        long long frameTotal = 0;
+        bool ranThisFrame = false;
+        float last = 0;
+    };
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    Zone zones[maxZones];
+    std::atomic<int> zoneCount = 0;
+
+    std::vector<TraceEvent> traceEvents;
+    int traceIndex = 0;
+    long long lastFrameEnd = 0;
+    bool overlayVisible = false;
+
+    ThreadBuffer* GetThreadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = threadBuffers.back().get();
+            buffer->threadIndex = (int) threadBuffers.size() - 1;
+        }
+
+        return buffer;
+    }
+
+    void PushWindow(Zone& zone, float value) {
+        zone.window[zone.windowIndex] = value;
+        zone.windowIndex = (zone.windowIndex + 1) % windowSize;
+        zone.windowCount = std::min(zone.windowCount + 1, windowSize);
+        zone.last = value;
+    }
+
+    int RegisterZone(const char* name) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        int count = zoneCount.load();
+        for (int i = 0; i < count; i++) {
+            if (std::string(zones[i].name) == name)
+                return i;
+        }
+
+        if (count >= maxZones) {
+            std::cout << "[Error] Too many profiler zones\n";
+            return maxZones - 1;
+        }
+
+        zones[count].name = name;
+        zoneCount = count + 1;
+        return count;
+    }
+
+    void Record(int zone, long long start, long long end) {
+        ThreadBuffer* buffer = GetThreadBuffer();
+        unsigned int head = buffer->head.load(std::memory_order_relaxed);
+
+        if (head - buffer->tail.load(std::memory_order_acquire) >= ringCapacity) {
+            buffer->dropped++;
+            return;
+        }
+
+        buffer->events[head % ringCapacity] = ZoneEvent {zone, start, end};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void EndFrame() {
+        static const int frameZone = RegisterZone("Frame");
+
+        long long now = Now();
+        if (lastFrameEnd != 0)
+            Record(frameZone, lastFrameEnd, now);
+        lastFrameEnd = now;
+
+        if (traceEvents.empty())
+            traceEvents.resize(maxTraceEvents);
+
+        // Kept between frames so draining the buffers doesn't allocate
+        static std::vector<ThreadBuffer*> buffers;
+        buffers.clear();
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (auto &buffer : threadBuffers) {
+                buffers.push_back(buffer.get());
+            }
+        }
+
+        for (ThreadBuffer* buffer : buffers) {
+            unsigned int tail = buffer->tail.load(std::memory_order_relaxed);
+            unsigned int head = buffer->head.load(std::memory_order_acquire);
+
+            for (; tail != head; tail++) {
+                ZoneEvent &event = buffer->events[tail % ringCapacity];
+                Zone &zone = zones[event.zone];
+                zone.frameTotal += event.end - event.start;
+                zone.ranThisFrame = true;
+
+                traceEvents[traceIndex % maxTraceEvents] = TraceEvent {event, buffer->threadIndex};
+                traceIndex++;
+            }
+
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+
+        int count = zoneCount.load();
+        for (int i = 0; i < count; i++) {
+            Zone &zone = zones[i];
+            if (!zone.ranThisFrame) continue;
+
+            PushWindow(zone, zone.frameTotal / 1000000.0f);
+            zone.frameTotal = 0;
+            zone.ranThisFrame = false;
+        }
+    }
+
+    std::vector<ZoneStats> GetStats() {
+        std::vector<ZoneStats> stats;
+        float sorted[windowSize];
+
+        int count = zoneCount.load();
+        for (int i = 0; i < count; i++) {
+            Zone &zone = zones[i];
+            if (!zone.windowCount) continue;
+
+            std::copy(zone.window, zone.window + zone.windowCount, sorted);
+            std::sort(sorted, sorted + zone.windowCount);
+
+            float total = 0;
+            for (int j = 0; j < zone.windowCount; j++) {
+                total += sorted[j];
+            }
+
+            stats.push_back(ZoneStats {
+                .name = zone.name,
+                .min = sorted[0],
+                .avg = total / zone.windowCount,
+                .p99 = sorted[std::min((int) (zone.windowCount * 0.99f), zone.windowCount - 1)],
+                .last = zone.last
+            });
+        }
+
+        return stats;
+    }
+
+    void UpdateOverlay() {
+        if (IsKeyPressed(KEY_F3))
+            overlayVisible = !overlayVisible;
+
+        if (IsKeyPressed(KEY_F4)) {
+            if (ExportChromeTrace("profile.json")) {
+                std::cout << "[Profiler] Wrote profile.json\n";
+            } else {
+                std::cout << "[Error] Could not write profile.json\n";
+            }
+        }
+
+        if (!overlayVisible)
+            return;
+
+        const int fontSize = 10;
+        const int lineHeight = 12;
+        std::vector<ZoneStats> stats = GetStats();
+
+        DrawRectangle(4, 4, 330, lineHeight * ((int) stats.size() + 1) + 8, ColorAlpha(BLACK, 0.8f));
+        DrawText("zone                      min    avg    p99  (ms)", 8, 8, fontSize, WHITE);
+
+        char line[128];
+        for (int i = 0; i < (signed) stats.size(); i++) {
+            snprintf(line, sizeof(line), "%-24s %6.2f %6.2f %6.2f", stats[i].name, stats[i].min, stats[i].avg, stats[i].p99);
+            DrawText(line, 8, 8 + lineHeight * (i + 1), fontSize, stats[i].p99 > 16.6f ? RED : WHITE);
+        }
+    }
+
+    bool ExportChromeTrace(const char* path) {
+        std::ofstream file(path);
+        if (!file.is_open())
+            return false;
+
+        int total = std::min(traceIndex, maxTraceEvents);
+        int first = traceIndex - total;
+
+        // Events are drained a thread at a time so the oldest one isn't necessarily first
+        long long origin = total ? traceEvents[first % maxTraceEvents].event.start : 0;
+        for (int i = 0; i < total; i++) {
+            origin = std::min(origin, traceEvents[(first + i) % maxTraceEvents].event.start);
+        }
+
+        file << "{\"traceEvents\":[\n";
+        for (int i = 0; i < total; i++) {
+            TraceEvent &trace = traceEvents[(first + i) % maxTraceEvents];
+
+            file << (i ? ",\n" : "") << "{\"name\":\"" << zones[trace.event.zone].name
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << trace.threadIndex
+                << ",\"ts\":" << (trace.event.start - origin) / 1000.0
+                << ",\"dur\":" << (trace.event.end - trace.event.start) / 1000.0 << "}";
+        }
+        file << "\n]}\n";
+
+        return true;
+    }
+}
+
+#endif
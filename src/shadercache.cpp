@@ -0,0 +1,311 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include "shadercache.h"
+#include "rlgl.h"
+
+#if defined(PLATFORM_DESKTOP)
+
+// raylib doesn't expose program binaries, so the entry points are loaded through GLFW which raylib links
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+// GL's calling convention, only different from the default on 32 bit Windows
+#ifndef GLAPIENTRY
+#if defined(_WIN32)
+#define GLAPIENTRY __stdcall
+#else
+#define GLAPIENTRY
+#endif
+#endif
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+
+const GLenum GL_VENDOR = 0x1F00;
+const GLenum GL_RENDERER = 0x1F01;
+const GLenum GL_VERSION = 0x1F02;
+const GLenum GL_LINK_STATUS = 0x8B82;
+const GLenum GL_PROGRAM_BINARY_LENGTH = 0x8741;
+const GLenum GL_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+const GLenum GL_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const GLint GL_TRUE = 1;
+
+typedef const unsigned char* (GLAPIENTRY *GetStringFunction)(GLenum name);
+typedef void (GLAPIENTRY *GetIntegervFunction)(GLenum name, GLint* data);
+typedef GLuint (GLAPIENTRY *CreateProgramFunction)();
+typedef void (GLAPIENTRY *DeleteProgramFunction)(GLuint program);
+typedef void (GLAPIENTRY *AttachShaderFunction)(GLuint program, GLuint shader);
+typedef void (GLAPIENTRY *DetachShaderFunction)(GLuint program, GLuint shader);
+typedef void (GLAPIENTRY *DeleteShaderFunction)(GLuint shader);
+typedef void (GLAPIENTRY *BindAttribLocationFunction)(GLuint program, GLuint index, const char* name);
+typedef void (GLAPIENTRY *LinkProgramFunction)(GLuint program);
+typedef void (GLAPIENTRY *GetProgramivFunction)(GLuint program, GLenum name, GLint* params);
+typedef void (GLAPIENTRY *ProgramParameteriFunction)(GLuint program, GLenum name, GLint value);
+typedef void (GLAPIENTRY *GetProgramBinaryFunction)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* format, void* binary);
+typedef void (GLAPIENTRY *ProgramBinaryFunction)(GLuint program, GLenum format, const void* binary, GLsizei length);
+
+struct ProgramBinaryFunctions {
+    GetStringFunction getString;
+    GetIntegervFunction getIntegerv;
+    CreateProgramFunction createProgram;
+    DeleteProgramFunction deleteProgram;
+    AttachShaderFunction attachShader;
+    DetachShaderFunction detachShader;
+    DeleteShaderFunction deleteShader;
+    BindAttribLocationFunction bindAttribLocation;
+    LinkProgramFunction linkProgram;
+    GetProgramivFunction getProgramiv;
+    ProgramParameteriFunction programParameteri;
+    GetProgramBinaryFunction getProgramBinary;
+    ProgramBinaryFunction programBinary;
+};
+
+// Null when the driver has no program binary support
+static ProgramBinaryFunctions* GetFunctions() {
+    static bool loaded = false;
+    static ProgramBinaryFunctions functions;
+    static bool supported = false;
+
+    if (!loaded) {
+        loaded = true;
+        functions = ProgramBinaryFunctions {
+            .getString = (GetStringFunction) glfwGetProcAddress("glGetString"),
+            .getIntegerv = (GetIntegervFunction) glfwGetProcAddress("glGetIntegerv"),
+            .createProgram = (CreateProgramFunction) glfwGetProcAddress("glCreateProgram"),
+            .deleteProgram = (DeleteProgramFunction) glfwGetProcAddress("glDeleteProgram"),
+            .attachShader = (AttachShaderFunction) glfwGetProcAddress("glAttachShader"),
+            .detachShader = (DetachShaderFunction) glfwGetProcAddress("glDetachShader"),
+            .deleteShader = (DeleteShaderFunction) glfwGetProcAddress("glDeleteShader"),
+            .bindAttribLocation = (BindAttribLocationFunction) glfwGetProcAddress("glBindAttribLocation"),
+            .linkProgram = (LinkProgramFunction) glfwGetProcAddress("glLinkProgram"),
+            .getProgramiv = (GetProgramivFunction) glfwGetProcAddress("glGetProgramiv"),
+            .programParameteri = (ProgramParameteriFunction) glfwGetProcAddress("glProgramParameteri"),
+            .getProgramBinary = (GetProgramBinaryFunction) glfwGetProcAddress("glGetProgramBinary"),
+            .programBinary = (ProgramBinaryFunction) glfwGetProcAddress("glProgramBinary"),
+        };
+
+        supported = functions.getString && functions.getIntegerv && functions.createProgram && functions.deleteProgram
+            && functions.attachShader && functions.detachShader && functions.deleteShader
+            && functions.bindAttribLocation && functions.linkProgram && functions.getProgramiv && functions.programParameteri
+            && functions.getProgramBinary && functions.programBinary;
+
+        if (supported) {
+            GLint formats = 0;
+            functions.getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0;
+        }
+    }
+
+    return supported ? &functions : nullptr;
+}
+
+struct CacheHeader {
+    char magic[4];
+    GLenum format;
+    GLsizei length;
+};
+
+static unsigned long long Fnv1a(std::string_view data, unsigned long long hash = 14695981039346656037ull) {
+    for (unsigned char character : data) {
+        hash = (hash ^ character) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string GlString(ProgramBinaryFunctions* gl, GLenum name) {
+    const unsigned char* value = gl->getString(name);
+    return value ? (const char*) value : "";
+}
+
+static std::filesystem::path CachePath(ProgramBinaryFunctions* gl, std::string_view source) {
+    unsigned long long hash = Fnv1a(source);
+    hash = Fnv1a(RAYLIB_VERSION, hash);
+    hash = Fnv1a(GlString(gl, GL_VENDOR), hash);
+    hash = Fnv1a(GlString(gl, GL_RENDERER), hash);
+    hash = Fnv1a(GlString(gl, GL_VERSION), hash);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", hash);
+    return std::filesystem::path(shaderCacheDir) / name;
+}
+
+// Same default locations LoadShaderFromMemory looks up
+static Shader ShaderFromProgram(unsigned int id) {
+    Shader shader = {id, (int*) calloc(RL_MAX_SHADER_LOCATIONS, sizeof(int))};
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) {
+        shader.locs[i] = -1;
+    }
+
+    shader.locs[SHADER_LOC_VERTEX_POSITION] = rlGetLocationAttrib(id, "vertexPosition");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(id, "vertexTexCoord");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] = rlGetLocationAttrib(id, "vertexTexCoord2");
+    shader.locs[SHADER_LOC_VERTEX_NORMAL] = rlGetLocationAttrib(id, "vertexNormal");
+    shader.locs[SHADER_LOC_VERTEX_TANGENT] = rlGetLocationAttrib(id, "vertexTangent");
+    shader.locs[SHADER_LOC_VERTEX_COLOR] = rlGetLocationAttrib(id, "vertexColor");
+    shader.locs[SHADER_LOC_MATRIX_MVP] = rlGetLocationUniform(id, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_VIEW] = rlGetLocationUniform(id, "matView");
+    shader.locs[SHADER_LOC_MATRIX_PROJECTION] = rlGetLocationUniform(id, "matProjection");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = rlGetLocationUniform(id, "matModel");
+    shader.locs[SHADER_LOC_MATRIX_NORMAL] = rlGetLocationUniform(id, "matNormal");
+    shader.locs[SHADER_LOC_COLOR_DIFFUSE] = rlGetLocationUniform(id, "colDiffuse");
+    shader.locs[SHADER_LOC_MAP_DIFFUSE] = rlGetLocationUniform(id, "texture0");
+    shader.locs[SHADER_LOC_MAP_SPECULAR] = rlGetLocationUniform(id, "texture1");
+    shader.locs[SHADER_LOC_MAP_NORMAL] = rlGetLocationUniform(id, "texture2");
+
+    return shader;
+}
+
+static bool LoadFromCache(ProgramBinaryFunctions* gl, const std::filesystem::path& path, Shader& shader) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    CacheHeader header;
+    if (!file.read((char*) &header, sizeof(header)) || std::string_view(header.magic, 4) != "STSC" || header.length <= 0)
+        return false;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), header.length))
+        return false;
+
+    GLuint program = gl->createProgram();
+    gl->programBinary(program, header.format, binary.data(), header.length);
+
+    // Drivers reject binaries from other versions, compile from source then
+    GLint linked = 0;
+    gl->getProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        gl->deleteProgram(program);
+        return false;
+    }
+
+    shader = ShaderFromProgram(program);
+    return true;
+}
+
+// raylib's default GL 3.3 vertex shader, the stage LoadShader(0, path) links the fragment shader with
+static const char* defaultVertexShader = R"(#version 330
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec4 vertexColor;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+uniform mat4 mvp;
+void main()
+{
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
+)";
+
+// Links the program here instead of through LoadShader so the retrievable hint is set before its
+// only link. Attributes are bound like rlLoadShaderProgram does, raylib's batch expects those slots
+static bool CompileRetrievable(ProgramBinaryFunctions* gl, const char* fsCode, Shader& shader) {
+    GLuint vertex = rlCompileShader(defaultVertexShader, RL_VERTEX_SHADER);
+    GLuint fragment = vertex ? rlCompileShader(fsCode, RL_FRAGMENT_SHADER) : 0;
+    if (!fragment) {
+        if (vertex)
+            gl->deleteShader(vertex);
+        return false;
+    }
+
+    GLuint program = gl->createProgram();
+    gl->attachShader(program, vertex);
+    gl->attachShader(program, fragment);
+
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+    gl->bindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+
+    gl->programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    gl->linkProgram(program);
+
+    gl->detachShader(program, vertex);
+    gl->detachShader(program, fragment);
+    gl->deleteShader(vertex);
+    gl->deleteShader(fragment);
+
+    GLint linked = 0;
+    gl->getProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        gl->deleteProgram(program);
+        return false;
+    }
+
+    shader = ShaderFromProgram(program);
+    return true;
+}
+
+static void SaveToCache(ProgramBinaryFunctions* gl, const std::filesystem::path& path, Shader shader) {
+    GLint length = 0;
+    gl->getProgramiv(shader.id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    CacheHeader header = {{'S', 'T', 'S', 'C'}, 0, 0};
+    std::vector<char> binary(length);
+    gl->getProgramBinary(shader.id, length, &header.length, &header.format, binary.data());
+    if (header.length <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "[Error] Couldn't write the shader cache file " << path.string() << "\n";
+        return;
+    }
+
+    file.write((char*) &header, sizeof(header));
+    file.write(binary.data(), header.length);
+}
+
+#endif
+
+Shader LoadShaderCached(const char* fsPath) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+#if defined(PLATFORM_DESKTOP)
+    ProgramBinaryFunctions* gl = shaderCacheDir.empty() ? nullptr : GetFunctions();
+    char* source = gl ? LoadFileText(fsPath) : nullptr;
+
+    if (source != nullptr) {
+        std::filesystem::path path = CachePath(gl, source);
+
+        Shader shader;
+        if (LoadFromCache(gl, path, shader)) {
+            UnloadFileText(source);
+            std::cout << "[Shaders] " << fsPath << ": loaded from cache in " << elapsedMs() << "ms\n";
+            return shader;
+        }
+
+        bool compiled = CompileRetrievable(gl, source, shader);
+        UnloadFileText(source);
+
+        if (compiled) {
+            SaveToCache(gl, path, shader);
+        } else {
+            // LoadShader reports what failed and hands back raylib's default shader
+            shader = LoadShader(0, fsPath);
+        }
+
+        std::cout << "[Shaders] " << fsPath << ": compiled in " << elapsedMs() << "ms\n";
+        return shader;
+    }
+#endif
+
+    Shader shader = LoadShader(0, fsPath);
+    std::cout << "[Shaders] " << fsPath << ": compiled in " << elapsedMs() << "ms (no cache)\n";
+    return shader;
+}
@@ -1,36 +1,260 @@
 #include "simulation.h"
+#include "debug.h"
 
 Simulation::Simulation(int width, int height) : width(width), height(height) {
-    sandBuffer = std::unique_ptr<SandParticle[]>(new SandParticle[width * height]);
+    chunksX = (width + chunkSize - 1) / chunkSize;
+    chunksY = (height + chunkSize - 1) / chunkSize;
     Clear();
 }
 
-void Simulation::Step() {
-    for (int y = height - 2; y > -1; y--) {
-        for (int x = 0; x < width; x++) {
-            SandParticle particle = *GetAt(x, y);
-            if (!particle.occupied) continue;
-
-            // Can Move Down?
-            if (!GetAt(x, y + 1)->occupied) {
-                SetAt(x, y, SandParticle{});
+Simulation::Simulation(const Simulation& other) {
+    *this = other;
+}
+
+Simulation& Simulation::operator=(const Simulation& other) {
+    if (this == &other)
+        return *this;
+
+    if (width != other.width || height != other.height) {
+        width = other.width;
+        height = other.height;
+        chunksX = other.chunksX;
+        chunksY = other.chunksY;
+        Clear();
+    }
+
+    steps = other.steps;
+    maxFallSpeed = other.maxFallSpeed;
+    MarkDirty(0, 0, width - 1, height - 1);
+    columnTops = other.columnTops;
+    highestPoint = other.highestPoint;
+    highestDirty = other.highestDirty;
+
+    // Reuse the chunks that are already allocated so cloning boards every frame doesn't allocate
+    for (int i = 0; i < (signed) chunks.size(); i++) {
+        SandChunk* source = other.chunks[i].get();
+
+        if (source == nullptr || !source->occupied) {
+            ReleaseChunk(chunks[i]);
+        } else {
+            if (!chunks[i])
+                chunks[i] = NewChunk();
+            *chunks[i] = *source;
+        }
+    }
+
+    return *this;
+}
+
+// Empty cells straight below a particle that can fall, searched up to speed cells. Grains of a
+// falling column are moved bottom first so the ones above see the gap their neighbour left
+int Simulation::FallDistance(int x, int y, int speed) {
+    int distance = 1;
+    while (distance < speed && y + distance + 1 < height && !GetAt(x, y + distance + 1)->occupied) {
+        distance++;
+    }
+    return distance;
+}
+
+// Moves the particles of one material in a row of a chunk, starting at x and stopping at the
+// first particle of another material. Returns where to carry on, which is past xEnd when a
+// particle flowed into the next chunk so it isn't moved twice
+template<Material material>
+int Simulation::StepRun(SandChunk* chunk, int row, int y, int x, int xEnd) {
+    using Rule = MaterialRule<material>;
+
+    for (; x < xEnd; x++) {
+        SandParticle particle = chunk->particles[row * chunkSize + (x & chunkMask)];
+        if (!particle.occupied) continue;
+        if (particle.material != material) return x;
+        if constexpr (!Rule::falls) continue;
+
+        // Can Move Down?
+        SandParticle* below = GetAt(x, y + 1);
+        if (!below->occupied) {
+            int distance = 1;
+            if (maxFallSpeed > 1) {
+                particle.velocity = std::min(particle.velocity + 1, maxFallSpeed);
+                distance = FallDistance(x, y, particle.velocity);
+            }
+
+            particle.spread = Rule::spreadDistance;
+            SetAt(x, y, SandParticle{});
+            SetAt(x, y + distance, particle);
+            continue;
+        }
+
+        // Landed
+        if (particle.velocity) {
+            chunk->particles[row * chunkSize + (x & chunkMask)].velocity = 0;
+            particle.velocity = 0;
+        }
+
+        if constexpr (Rule::sinks) {
+            if (below->material == Material::Liquid) {
+                SandParticle displaced = *below;
+                displaced.spread = MaterialRule<Material::Liquid>::spreadDistance;
+                SetAt(x, y, displaced);
                 SetAt(x, y + 1, particle);
                 continue;
             }
+        }
 
-            // Can Move Side?
+        // Can Move Side?
+        if constexpr (Rule::slides) {
             if (x + 1 < width && !GetAt(x + 1, y + 1)->occupied && !GetAt(x + 1, y)->occupied) {
+                particle.spread = Rule::spreadDistance;
                 SetAt(x, y, SandParticle {});
                 SetAt(x + 1, y + 1, particle);
                 continue;
             }
-            
+
             if (x > 0 && !GetAt(x - 1, y + 1)->occupied && !GetAt(x - 1, y)->occupied) {
+                particle.spread = Rule::spreadDistance;
                 SetAt(x, y, SandParticle {});
                 SetAt(x - 1, y + 1, particle);
+                continue;
+            }
+        }
+
+        // The side tried first alternates between steps and rows so liquid levels out both ways.
+        // It only flows for a while after it last moved down, so a puddle comes to rest and
+        // stops changing the board instead of shuffling its edges every step
+        if constexpr (Rule::flows) {
+            if (!particle.spread) continue;
+            particle.spread--;
+
+            bool canFlowLeft = x > 0 && !GetAt(x - 1, y)->occupied;
+            bool canFlowRight = x + 1 < width && !GetAt(x + 1, y)->occupied;
+
+            if (canFlowLeft && (!canFlowRight || (steps + y) & 1)) {
+                SetAt(x, y, SandParticle {});
+                SetAt(x - 1, y, particle);
+            } else if (canFlowRight) {
+                // Skip the particle that was just moved right
+                SetAt(x, y, SandParticle {});
+                SetAt(x + 1, y, particle);
+                x++;
             }
         }
     }
+
+    return x;
+}
+
+void Simulation::Step() {
+    PROFILE_ZONE("Simulation::Step");
+    steps++;
+
+    // Same bottom to top, left to right order as a plain scan of the board, but rows
+    // of a chunk outside of its occupied range and empty chunks are skipped
+    for (int cy = chunksY - 1; cy > -1; cy--) {
+        if (ChunkRowEmpty(cy)) continue;
+
+        int top = cy * chunkSize;
+        for (int y = std::min(top + chunkSize - 1, height - 2); y >= top; y--) {
+            int row = y - top;
+            int x = 0;
+
+            for (int cx = 0; cx < chunksX; cx++) {
+                SandChunk* chunk = chunks[cy * chunksX + cx].get();
+                if (chunk == nullptr || !chunk->occupied || row < chunk->minRow || row > chunk->maxRow) continue;
+
+                int xEnd = std::min((cx + 1) * chunkSize, width);
+                x = std::max(x, cx * chunkSize);
+
+                // Each run of particles of the same material goes through that material's kernel,
+                // so the material only has to be looked at where it changes
+                while (x < xEnd) {
+                    switch (chunk->particles[row * chunkSize + (x & chunkMask)].material) {
+                        case Material::Sand:
+                            x = StepRun<Material::Sand>(chunk, row, y, x, xEnd);
+                            break;
+                        case Material::HeavySand:
+                            x = StepRun<Material::HeavySand>(chunk, row, y, x, xEnd);
+                            break;
+                        case Material::Liquid:
+                            x = StepRun<Material::Liquid>(chunk, row, y, x, xEnd);
+                            break;
+                        case Material::Rock:
+                            x = StepRun<Material::Rock>(chunk, row, y, x, xEnd);
+                            break;
+                    }
+                }
+            }
+        }
+    }
+
+    ReleaseEmptyChunks();
+}
+
+// Drops every particle straight down until it rests on the floor or another particle,
+// keeping the order of each column. Every column is compacted on its own a chunk at a
+// time, moving the grains directly in the chunks, and its heightmap entry and dirty
+// box are written once at the end instead of for every grain
+int Simulation::Settle() {
+    int moved = 0;
+
+    for (int x = 0; x < width; x++) {
+        int cx = x >> chunkShift;
+        int column = x & chunkMask;
+        int writeRow = height - 1;
+        int top = height;
+        int changedTop = height;
+        int changedBottom = -1;
+
+        for (int cy = chunksY - 1; cy > -1; cy--) {
+            SandChunk* chunk = chunks[cy * chunksX + cx].get();
+            if (chunk == nullptr || !chunk->occupied) continue;
+
+            for (int row = chunk->maxRow; row >= chunk->minRow; row--) {
+                SandParticle &particle = chunk->particles[row * chunkSize + column];
+                if (!particle.occupied) continue;
+
+                int y = cy * chunkSize + row;
+
+                // Rock stays put and the column above it settles onto it
+                if (particle.material == Material::Rock) {
+                    writeRow = y - 1;
+                    top = y;
+                    continue;
+                }
+
+                int target = writeRow--;
+                top = target;
+                if (target == y) continue;
+
+                std::unique_ptr<SandChunk> &targetChunk = chunks[(target >> chunkShift) * chunksX + cx];
+                if (!targetChunk)
+                    targetChunk = NewChunk();
+
+                int targetRow = target & chunkMask;
+                targetChunk->particles[targetRow * chunkSize + column] = particle;
+                targetChunk->occupied++;
+                targetChunk->minRow = std::min(targetChunk->minRow, targetRow);
+                targetChunk->maxRow = std::max(targetChunk->maxRow, targetRow);
+
+                // Grains only move down, so a chunk they left empty has nothing above to visit
+                particle = SandParticle{};
+                if (--chunk->occupied == 0) {
+                    chunk->minRow = chunkSize;
+                    chunk->maxRow = -1;
+                }
+
+                changedTop = std::min(changedTop, y);
+                changedBottom = std::max(changedBottom, target);
+                moved++;
+            }
+        }
+
+        if (changedBottom != -1)
+            MarkDirty(x, changedTop, x, changedBottom);
+        columnTops[x] = top;
+    }
+
+    highestDirty = true;
+    ReleaseEmptyChunks();
+    return moved;
 }
 
 SandParticle* Simulation::GetAt(int x, int y) {
@@ -38,26 +262,140 @@ SandParticle* Simulation::GetAt(int x, int y) {
         return nullptr;
     }
 
-    return &sandBuffer.get()[IndexAt(x, y)];
+    SandChunk* chunk = ChunkAt(x, y);
+    if (chunk == nullptr) {
+        air = SandParticle{};
+        return &air;
+    }
+
+    return &chunk->particles[(y & chunkMask) * chunkSize + (x & chunkMask)];
 }
 
 void Simulation::SetAt(int x, int y, SandParticle value) {
     if (!ValidPosition(x, y)) {   
         return;
     }
-    
-    sandBuffer.get()[IndexAt(x, y)] = value;
+
+    std::unique_ptr<SandChunk> &chunk = chunks[(y >> chunkShift) * chunksX + (x >> chunkShift)];
+    if (!chunk) {
+        if (!value.occupied) return;
+        chunk = NewChunk();
+    }
+
+    int row = y & chunkMask;
+    SandParticle &particle = chunk->particles[row * chunkSize + (x & chunkMask)];
+    bool wasOccupied = particle.occupied;
+
+    if (wasOccupied || value.occupied)
+        MarkDirty(x, y, x, y);
+
+    if (value.occupied) {
+        if (!particle.occupied)
+            chunk->occupied++;
+
+        chunk->minRow = std::min(chunk->minRow, row);
+        chunk->maxRow = std::max(chunk->maxRow, row);
+    } else if (particle.occupied) {
+        // Empty chunks are released at the end of the next step
+        if (--chunk->occupied == 0) {
+            chunk->minRow = chunkSize;
+            chunk->maxRow = -1;
+        }
+    }
+
+    particle = value;
+
+    // Heightmap
+    if (value.occupied && !wasOccupied && y < columnTops[x]) {
+        columnTops[x] = y;
+        if (!highestDirty && y < highestPoint)
+            highestPoint = y;
+    } else if (!value.occupied && wasOccupied && y == columnTops[x]) {
+        if (y == highestPoint)
+            highestDirty = true;
+        FindColumnTop(x, y + 1);
+    }
+}
+
+// Copies a run of occupied particles into a row a chunk at a time, clipped to the board
+void Simulation::SetRow(int x, int y, const SandParticle* values, int count) {
+    if (y < 0 || y >= height)
+        return;
+
+    if (x < 0) {
+        values -= x;
+        count += x;
+        x = 0;
+    }
+
+    count = std::min(count, width - x);
+    int row = y & chunkMask;
+
+    if (count > 0)
+        MarkDirty(x, y, x + count - 1, y);
+
+    while (count > 0) {
+        std::unique_ptr<SandChunk> &chunk = chunks[(y >> chunkShift) * chunksX + (x >> chunkShift)];
+        if (!chunk)
+            chunk = NewChunk();
+
+        int column = x & chunkMask;
+        int run = std::min(count, chunkSize - column);
+        SandParticle* dest = &chunk->particles[row * chunkSize + column];
+
+        int replaced = 0;
+        for (int i = 0; i < run; i++) {
+            replaced += dest[i].occupied;
+        }
+
+        std::copy(values, values + run, dest);
+
+        chunk->occupied += run - replaced;
+        chunk->minRow = std::min(chunk->minRow, row);
+        chunk->maxRow = std::max(chunk->maxRow, row);
+
+        for (int i = 0; i < run; i++) {
+            columnTops[x + i] = std::min(columnTops[x + i], y);
+        }
+
+        if (!highestDirty && y < highestPoint)
+            highestPoint = y;
+
+        x += run;
+        values += run;
+        count -= run;
+    }
 }
 
 void Simulation::Clear() {
-    for (int i = 0; i < width * height; i++) {
-        sandBuffer.get()[i] = SandParticle{false};
+    for (auto &chunk : chunks) {
+        ReleaseChunk(chunk);
+    }
+
+    chunks.resize(chunksX * chunksY);
+
+    // Filled up front so the first chunks sand reaches during a game don't allocate
+    int spareTarget = std::min(maxSpareChunks, chunksX * chunksY);
+    spareChunks.reserve(maxSpareChunks);
+    while ((signed) spareChunks.size() < spareTarget) {
+        spareChunks.push_back(std::make_unique<SandChunk>());
     }
+    columnTops.assign(width, height);
+    highestPoint = height;
+    highestDirty = false;
+
+    // Nothing is left to connect, so the dirty area goes away with the sand
+    generation++;
+    dirty = {0, 0, -1, -1};
 }
 
 void Simulation::ResetVisited() {
-    for (int i = 0; i < width * height; i++) {
-        sandBuffer.get()[i].visited = false;
+    for (auto &chunk : chunks) {
+        if (!chunk) continue;
+
+        for (int i = chunk->minRow * chunkSize; i < (chunk->maxRow + 1) * chunkSize; i++) {
+            chunk->particles[i].visited = false;
+        }
     }
 }
 
@@ -66,15 +404,102 @@ int Simulation::IndexAt(int x, int y) {
 }
 
 int Simulation::GetHighestPoint() {
-    for (int i = 0; i < width * height; i++) {
-        if (sandBuffer.get()[i].occupied) {
-            return i / width;
+    if (highestDirty) {
+        highestPoint = height;
+        for (int top : columnTops) {
+            highestPoint = std::min(highestPoint, top);
         }
+        highestDirty = false;
     }
 
-    return height - 1;
+    return highestPoint < height ? highestPoint : height - 1;
 }
 
 bool Simulation::ValidPosition(int x, int y) {
     return (x >= 0 && x < width && y >= 0 and y < height);
 }
+
+DirtyBox Simulation::TakeDirtyBox() {
+    DirtyBox box = dirty;
+    dirty = {0, 0, -1, -1};
+    return box;
+}
+
+void Simulation::MarkDirty(int minX, int minY, int maxX, int maxY) {
+    generation++;
+
+    if (dirty.Empty()) {
+        dirty = {minX, minY, maxX, maxY};
+    } else {
+        dirty.minX = std::min(dirty.minX, minX);
+        dirty.minY = std::min(dirty.minY, minY);
+        dirty.maxX = std::max(dirty.maxX, maxX);
+        dirty.maxY = std::max(dirty.maxY, maxY);
+    }
+}
+
+int Simulation::AllocatedChunks() {
+    int total = 0;
+    for (auto &chunk : chunks) {
+        if (chunk) total++;
+    }
+    return total;
+}
+
+bool Simulation::ChunkRowEmpty(int cy) {
+    for (int cx = 0; cx < chunksX; cx++) {
+        SandChunk* chunk = chunks[cy * chunksX + cx].get();
+        if (chunk != nullptr && chunk->occupied)
+            return false;
+    }
+    return true;
+}
+
+void Simulation::ReleaseEmptyChunks() {
+    for (auto &chunk : chunks) {
+        if (chunk && !chunk->occupied)
+            ReleaseChunk(chunk);
+    }
+}
+
+void Simulation::ReleaseChunk(std::unique_ptr<SandChunk>& chunk) {
+    if (!chunk)
+        return;
+
+    if ((signed) spareChunks.size() < maxSpareChunks) {
+        spareChunks.push_back(std::move(chunk));
+    } else {
+        chunk.reset();
+    }
+}
+
+std::unique_ptr<SandChunk> Simulation::NewChunk() {
+    if (spareChunks.empty())
+        return std::make_unique<SandChunk>();
+
+    std::unique_ptr<SandChunk> chunk = std::move(spareChunks.back());
+    spareChunks.pop_back();
+    *chunk = SandChunk();
+    return chunk;
+}
+
+// Searches down a column from y for its new top, skipping chunks that aren't allocated
+void Simulation::FindColumnTop(int x, int y) {
+    while (y < height) {
+        SandChunk* chunk = ChunkAt(x, y);
+
+        if (chunk == nullptr || !chunk->occupied) {
+            y = (y | chunkMask) + 1;
+            continue;
+        }
+
+        if (chunk->particles[(y & chunkMask) * chunkSize + (x & chunkMask)].occupied) {
+            columnTops[x] = y;
+            return;
+        }
+
+        y++;
+    }
+
+    columnTops[x] = height;
+}
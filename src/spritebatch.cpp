@@ -0,0 +1,163 @@
+#include <algorithm>
+#include "rlgl.h"
+#include "spritebatch.h"
+
+struct BatchQuad {
+    BatchLayer layer;
+    Shader shader;
+    unsigned int texture;
+    float u0, v0, u1, v1;
+    Rectangle dest;
+    Color color;
+    int order;
+};
+
+static std::vector<BatchQuad> batchQuads;
+static Shader batchShader = {};
+static bool batchActive = false;
+static int lastDrawCalls = 0;
+
+void BeginSpriteBatch() {
+    batchQuads.clear();
+    batchShader = {};
+    batchActive = true;
+}
+
+void EndSpriteBatch() {
+    batchActive = false;
+
+    // Keep the submission order inside a group so overlapping quads still draw correctly,
+    // compared explicitly since std::stable_sort allocates a temporary buffer every call
+    std::sort(batchQuads.begin(), batchQuads.end(), [](const BatchQuad& a, const BatchQuad& b) {
+        if (a.layer != b.layer) return a.layer < b.layer;
+        if (a.shader.id != b.shader.id) return a.shader.id < b.shader.id;
+        if (a.texture != b.texture) return a.texture < b.texture;
+        return a.order < b.order;
+    });
+
+    int drawCalls = 0;
+    unsigned int currentShader = 0;
+
+    for (int start = 0; start < (signed) batchQuads.size();) {
+        const BatchQuad &first = batchQuads[start];
+
+        int end = start;
+        while (end < (signed) batchQuads.size() && batchQuads[end].layer == first.layer
+            && batchQuads[end].shader.id == first.shader.id && batchQuads[end].texture == first.texture) {
+            end++;
+        }
+
+        if (first.shader.id != currentShader) {
+            if (currentShader != 0)
+                EndShaderMode();
+            if (first.shader.id != 0)
+                BeginShaderMode(first.shader);
+            currentShader = first.shader.id;
+        }
+
+        rlSetTexture(first.texture);
+        rlBegin(RL_QUADS);
+
+        for (int i = start; i < end; i++) {
+            const BatchQuad &quad = batchQuads[i];
+            const Rectangle &dest = quad.dest;
+
+            rlColor4ub(quad.color.r, quad.color.g, quad.color.b, quad.color.a);
+            rlNormal3f(0, 0, 1);
+
+            rlTexCoord2f(quad.u0, quad.v0);
+            rlVertex2f(dest.x, dest.y);
+            rlTexCoord2f(quad.u0, quad.v1);
+            rlVertex2f(dest.x, dest.y + dest.height);
+            rlTexCoord2f(quad.u1, quad.v1);
+            rlVertex2f(dest.x + dest.width, dest.y + dest.height);
+            rlTexCoord2f(quad.u1, quad.v0);
+            rlVertex2f(dest.x + dest.width, dest.y);
+        }
+
+        rlEnd();
+        drawCalls++;
+        start = end;
+    }
+
+    rlSetTexture(0);
+    if (currentShader != 0)
+        EndShaderMode();
+
+    lastDrawCalls = drawCalls;
+    batchQuads.clear();
+}
+
+void SetBatchShader(Shader shader) {
+    batchShader = shader;
+}
+
+void BatchTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Color tint, BatchLayer layer) {
+    if (!batchActive) {
+        if (batchShader.id != 0) BeginShaderMode(batchShader);
+        DrawTexturePro(texture, source, dest, {0, 0}, 0, tint);
+        if (batchShader.id != 0) EndShaderMode();
+        return;
+    }
+
+    if (texture.id == 0)
+        return;
+
+    bool flipX = source.width < 0;
+    bool flipY = source.height < 0;
+    source.width = std::abs(source.width);
+    source.height = std::abs(source.height);
+
+    float left = source.x / texture.width;
+    float right = (source.x + source.width) / texture.width;
+    float top = source.y / texture.height;
+    float bottom = (source.y + source.height) / texture.height;
+
+    batchQuads.push_back(BatchQuad {
+        .layer = layer,
+        .shader = batchShader,
+        .texture = texture.id,
+        .u0 = flipX ? right : left,
+        .v0 = flipY ? bottom : top,
+        .u1 = flipX ? left : right,
+        .v1 = flipY ? top : bottom,
+        .dest = dest,
+        .color = tint,
+        .order = (int) batchQuads.size()
+    });
+}
+
+void BatchRectangle(Rectangle rect, Color color, BatchLayer layer) {
+    if (!batchActive) {
+        DrawRectangleRec(rect, color);
+        return;
+    }
+
+    // The default texture is a single white pixel
+    batchQuads.push_back(BatchQuad {
+        .layer = layer,
+        .shader = batchShader,
+        .texture = rlGetTextureIdDefault(),
+        .u0 = 0, .v0 = 0, .u1 = 1, .v1 = 1,
+        .dest = rect,
+        .color = color,
+        .order = (int) batchQuads.size()
+    });
+}
+
+void BatchRectangleLines(Rectangle rect, float thickness, Color color, BatchLayer layer) {
+    if (!batchActive) {
+        DrawRectangleLinesEx(rect, thickness, color);
+        return;
+    }
+
+    // Same split as DrawRectangleLinesEx
+    BatchRectangle({rect.x, rect.y, rect.width, thickness}, color, layer);
+    BatchRectangle({rect.x, rect.y + rect.height - thickness, rect.width, thickness}, color, layer);
+    BatchRectangle({rect.x, rect.y + thickness, thickness, rect.height - thickness * 2}, color, layer);
+    BatchRectangle({rect.x + rect.width - thickness, rect.y + thickness, thickness, rect.height - thickness * 2}, color, layer);
+}
+
+int GetBatchDrawCalls() {
+    return lastDrawCalls;
+}
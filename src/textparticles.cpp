@@ -0,0 +1,137 @@
+#include <algorithm>
+#include "textparticles.h"
+#include "easetables.h"
+#include "spritebatch.h"
+
+void TextParticleSystem::Load(PixelFont* _font) {
+    font = _font;
+    particles.reserve(capacity);
+
+    layouts.resize(maxLayouts);
+    for (TextLayout &layout : layouts) {
+        layout.glyphs.reserve(maxTextLength);
+    }
+}
+
+void TextParticleSystem::Spawn(std::string_view text, TextParticle particle) {
+    if ((signed) particles.size() >= capacity)
+        return;
+
+    particle.text = Intern(text);
+    if (particle.text == -1)
+        return;
+
+    particle.timer = 0;
+    particles.push_back(particle);
+}
+
+void TextParticleSystem::Clear() {
+    particles.clear();
+}
+
+int TextParticleSystem::Intern(std::string_view text) {
+    text = text.substr(0, maxTextLength);
+
+    for (int i = 0; i < usedLayouts; i++) {
+        if (std::string_view(layouts[i].text, layouts[i].length) == text)
+            return i;
+    }
+
+    int id = -1;
+    if (usedLayouts < maxLayouts) {
+        id = usedLayouts++;
+    } else {
+        // Replace the next layout, going round the table, that no particle still shows
+        bool shown[maxLayouts] = {};
+        for (const TextParticle &particle : particles) {
+            shown[particle.text] = true;
+        }
+
+        for (int i = 0; i < maxLayouts && id == -1; i++) {
+            int candidate = (nextReplaced + i) % maxLayouts;
+            if (!shown[candidate])
+                id = candidate;
+        }
+
+        if (id == -1)
+            return -1;
+        nextReplaced = (id + 1) % maxLayouts;
+    }
+
+    TextLayout &layout = layouts[id];
+    std::copy(text.begin(), text.end(), layout.text);
+    layout.length = text.size();
+    layout.width = font->Layout(text, layout.glyphs);
+    return id;
+}
+
+void TextParticleSystem::Update(FrameArena& arena) {
+    // Lay the timings out as arrays in the frame arena so every curve is eased in one batch
+    int count = particles.size();
+    auto scratch = [&]() {return arena.AllocateArray<float>(count).data();};
+
+    float* fadeInTimer = scratch();
+    float* fadeInTime = scratch();
+    float* fadeOutTimer = scratch();
+    float* fadeOutTime = scratch();
+    float* zero = scratch();
+    float* one = scratch();
+    float* fadeOutAmount = scratch();
+    float* ascendDistance = scratch();
+    float* descendDistance = scratch();
+
+    for (int i = 0; i < count; i++) {
+        TextParticle &particle = particles[i];
+        particle.timer++;
+
+        fadeInTimer[i] = std::min(particle.timer - particle.startDelay, particle.fadeInTime);
+        fadeInTime[i] = particle.fadeInTime;
+        fadeOutTimer[i] = std::max(particle.timer - particle.fadeInTime, 0);
+        fadeOutTime[i] = particle.fadeOutTime;
+        zero[i] = 0;
+        one[i] = 1;
+        fadeOutAmount[i] = 0.8f;
+        ascendDistance[i] = particle.ascendDistance;
+        descendDistance[i] = particle.descendDistance;
+    }
+
+    float* fadeInOpacity = scratch();
+    float* fadeOutOpacity = scratch();
+    float* ascended = scratch();
+    float* descended = scratch();
+
+    EaseBatch(EaseCurve::CubicOut, fadeInTimer, fadeInTime, zero, one, fadeInOpacity, count);
+    EaseBatch(EaseCurve::CubicIn, fadeOutTimer, fadeOutTime, zero, fadeOutAmount, fadeOutOpacity, count);
+    EaseBatch(EaseCurve::CubicOut, fadeInTimer, fadeInTime, zero, ascendDistance, ascended, count);
+    EaseBatch(EaseCurve::CubicIn, fadeOutTimer, fadeOutTime, zero, descendDistance, descended, count);
+
+    BeginSpriteBatch();
+
+    for (int i = 0; i < count; i++) {
+        TextParticle &particle = particles[i];
+        if (particle.timer < particle.startDelay) continue;
+
+        TextLayout &layout = layouts[particle.text];
+        Color color = ColorAlpha(particle.color, std::min(fadeInOpacity[i], 1.0f) - fadeOutOpacity[i]);
+
+        // Centered horizontally on the start position
+        Vector2 pos = {
+            particle.startPos.x - layout.width * particle.size / 2,
+            particle.startPos.y - ascended[i] + descended[i]
+        };
+
+        font->RenderLayout(layout.glyphs, pos, particle.size, color);
+    }
+
+    EndSpriteBatch();
+
+    // Expire by swapping with the last particle, iterating backwards so every particle is checked
+    for (int i = count - 1; i > -1; i--) {
+        TextParticle &particle = particles[i];
+
+        if (particle.timer > particle.fadeInTime + particle.fadeOutTime) {
+            particle = particles.back();
+            particles.pop_back();
+        }
+    }
+}
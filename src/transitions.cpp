@@ -1,33 +1,128 @@
+#include "rlgl.h"
 #include "transitions.h"
-#include "easing.h"
 
-void ArrowTransition::Draw()  {
-    if (timer < duration)
-        timer++;
+static void Triangle(Vector2 a, Vector2 b, Vector2 c) {
+    rlVertex2f(a.x, a.y);
+    rlVertex2f(b.x, b.y);
+    rlVertex2f(c.x, c.y);
+}
+
+static void Rect(Rectangle rect) {
+    Vector2 topLeft = {rect.x, rect.y};
+    Vector2 topRight = {rect.x + rect.width, rect.y};
+    Vector2 bottomLeft = {rect.x, rect.y + rect.height};
+    Vector2 bottomRight = {rect.x + rect.width, rect.y + rect.height};
+
+    Triangle(topLeft, bottomLeft, topRight);
+    Triangle(topRight, bottomLeft, bottomRight);
+}
+
+TransitionHandle TransitionManager::Add(TransitionType type, Color color, int duration, int arrowOffset,
+    std::function<void()> onFinished, EaseCurve curve) {
+
+    for (int i = 0; i < capacity; i++) {
+        Slot &slot = slots[i];
+        if (slot.active) continue;
 
-    float x = easingFunction(timer, duration, -arrowOffset, GetScreenWidth() + arrowOffset);
+        slot.type = type;
+        slot.color = color;
+        slot.duration = duration;
+        slot.timer = 0;
+        slot.arrowOffset = arrowOffset;
+        slot.curve = curve;
+        slot.easeTable = FindEaseTable(curve, duration);
+        slot.onFinished = std::move(onFinished);
+        slot.generation++;
+        slot.active = true;
 
-    if (x > 0) 
-        DrawRectangleRec({0, 0, x, (float) GetScreenHeight()}, color);
+        return TransitionHandle {i, slot.generation};
+    }
 
-    DrawTriangle({x, (float) GetScreenHeight()}, {x + arrowOffset, GetScreenHeight() * 0.5f}, {x, 0}, color);
+    std::cout << "[Error] Too many transitions, the limit is " << capacity << "\n";
+    return {};
 }
 
-bool ArrowTransition::isFinished() {
-    return timer >= duration;
+bool TransitionManager::IsActive(TransitionHandle handle) {
+    if (handle.index < 0 || handle.index >= capacity)
+        return false;
+
+    Slot &slot = slots[handle.index];
+    return slot.active && slot.generation == handle.generation;
+}
+
+int TransitionManager::ActiveCount() {
+    int count = 0;
+    for (Slot &slot : slots) {
+        count += slot.active;
+    }
+    return count;
 }
 
-void ReverseArrowTransition::Draw()  {
-    if (timer < duration)
-        timer++;
+void TransitionManager::Update() {
+    // Free the finished slots before calling back so the callbacks can start new transitions
+    std::function<void()> callbacks[capacity];
+    int totalCallbacks = 0;
+
+    for (Slot &slot : slots) {
+        if (slot.active && slot.timer >= slot.duration) {
+            slot.active = false;
+            if (slot.onFinished)
+                callbacks[totalCallbacks++] = std::move(slot.onFinished);
+            slot.onFinished = nullptr;
+        }
+    }
+
+    for (int i = 0; i < totalCallbacks; i++) {
+        callbacks[i]();
+    }
+
+    if (!ActiveCount())
+        return;
 
-    float x = easingFunction(timer, duration, 0, GetScreenWidth() + arrowOffset);
+    rlBegin(RL_TRIANGLES);
 
-    DrawRectangleRec({x, 0, GetScreenWidth() - x, (float) GetScreenHeight()}, color);
-    DrawTriangle({x - arrowOffset, 0}, {x, GetScreenWidth() * 0.5f}, {x, 0}, color);
-    DrawTriangle({x, GetScreenWidth() * 0.5f}, {x - arrowOffset, (float) GetScreenHeight()}, {x, (float) GetScreenHeight()}, color);
+    for (Slot &slot : slots) {
+        if (!slot.active) continue;
+
+        if (slot.timer < slot.duration)
+            slot.timer++;
+
+        AppendGeometry(slot);
+    }
+
+    rlEnd();
 }
 
-bool ReverseArrowTransition::isFinished() {
-    return timer >= duration;
+void TransitionManager::AppendGeometry(Slot& slot) {
+    float width = (float) GetScreenWidth();
+    float height = (float) GetScreenHeight();
+
+    rlColor4ub(slot.color.r, slot.color.g, slot.color.b, slot.color.a);
+
+    switch (slot.type) {
+        case TransitionType::Arrow: {
+            float x = Ease(slot, -slot.arrowOffset, width + slot.arrowOffset);
+
+            if (x > 0)
+                Rect({0, 0, x, height});
+
+            Triangle({x, height}, {x + slot.arrowOffset, height * 0.5f}, {x, 0});
+            break;
+        }
+        case TransitionType::ReverseArrow: {
+            float x = Ease(slot, 0, width + slot.arrowOffset);
+
+            Rect({x, 0, width - x, height});
+            Triangle({x - slot.arrowOffset, 0}, {x, width * 0.5f}, {x, 0});
+            Triangle({x, width * 0.5f}, {x - slot.arrowOffset, height}, {x, height});
+            break;
+        }
+    }
+}
+
+float TransitionManager::Ease(Slot& slot, float startValue, float totalChange) {
+    if (slot.easeTable)
+        return startValue + totalChange * slot.easeTable[slot.timer];
+
+    return startValue + totalChange * EvaluateEase(slot.curve, (float) slot.timer / slot.duration);
 }
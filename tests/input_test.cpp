@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include "input.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cout << "[Error] " << __FILE__ << ":" << __LINE__ << ": " << #condition << "\n"; \
+        failures++; \
+    }
+
+const double frame = 1.0 / 60;
+
+static std::vector<KeyBinding> Bindings() {
+    return {
+        {KEY_A, InputAction::Left}, {KEY_D, InputAction::Right},
+        {KEY_S, InputAction::Down}, {KEY_W, InputAction::Rotate},
+        {KEY_SPACE, InputAction::HoldRotation}
+    };
+}
+
+// A Down press in the same frame as a rotation must not cancel the queued rotation
+static void RotationWithDownPress() {
+    InputRecorder recorder;
+    InputReader reader;
+    reader.Reset(recorder, Bindings(), 0);
+
+    recorder.Record(KEY_W, true, frame * 0.25);
+    recorder.Record(KEY_S, true, frame * 0.5);
+
+    GameInput input = reader.Read(recorder, frame);
+    CHECK(input.rotate);
+    CHECK(input.rotatePressTime == frame * 0.25);
+    CHECK(input.down >= 1);
+
+    reader.ConsumeRotation();
+    input = reader.Read(recorder, frame * 2);
+    CHECK(!input.rotate);
+    CHECK(input.down > 0);
+}
+
+// Two taps between frames rotate on two ticks, a third one doesn't fit the queue
+static void RotationsQueueUp() {
+    InputRecorder recorder;
+    InputReader reader;
+    reader.Reset(recorder, Bindings(), 0);
+
+    for (int i = 0; i < 3; i++) {
+        recorder.Record(KEY_W, true, frame * (0.2 + i * 0.2));
+        recorder.Record(KEY_W, false, frame * (0.3 + i * 0.2));
+    }
+
+    int rotations = 0;
+    for (int i = 1; i <= 4; i++) {
+        if (reader.Read(recorder, frame * i).rotate) {
+            rotations++;
+            reader.ConsumeRotation();
+        }
+    }
+    CHECK(rotations == InputReader::maxPendingRotations);
+}
+
+// A press nothing acted on is dropped once it's too old
+static void StaleRotationIsDropped() {
+    InputRecorder recorder;
+    InputReader reader;
+    reader.Reset(recorder, Bindings(), 0);
+
+    recorder.Record(KEY_W, true, frame * 0.5);
+    CHECK(reader.Read(recorder, frame).rotate);
+    CHECK(!reader.Read(recorder, frame + InputReader::rotationBufferTime).rotate);
+}
+
+// A tap let go before the frame ends still moves a whole tick, a held key moves by how long it was held
+static void TapsAndHolds() {
+    InputRecorder recorder;
+    InputReader reader;
+    reader.Reset(recorder, Bindings(), 0);
+
+    recorder.Record(KEY_A, true, frame * 0.4);
+    recorder.Record(KEY_A, false, frame * 0.6);
+    GameInput input = reader.Read(recorder, frame);
+    CHECK(input.left == 1);
+    CHECK(input.movePressTime == frame * 0.4);
+    CHECK(input.right == 0);
+
+    recorder.Record(KEY_D, true, frame * 1.5);
+    reader.Read(recorder, frame * 2);
+    input = reader.Read(recorder, frame * 3);
+    CHECK(std::abs(input.right - 1) < 0.001f);
+    CHECK(input.movePressTime == 0);
+}
+
+// Keys without a binding are skipped
+static void UnboundKeys() {
+    InputRecorder recorder;
+    InputReader reader;
+    const KeyBinding arrows[] = {{KEY_UP, InputAction::Rotate}};
+    reader.Reset(recorder, arrows, 0);
+
+    recorder.Record(KEY_W, true, frame * 0.5);
+    CHECK(!reader.Read(recorder, frame).rotate);
+}
+
+int main() {
+    RotationWithDownPress();
+    RotationsQueueUp();
+    StaleRotationIsDropped();
+    TapsAndHolds();
+    UnboundKeys();
+
+    if (failures) {
+        std::cout << "[Error] " << failures << " input checks failed\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "[Input] All checks passed\n";
+    return EXIT_SUCCESS;
+}